@@ -90,6 +90,7 @@ typedef struct _capture_file {
   dfilter_t                  *rfcode;               /* Compiled read filter program */
   dfilter_t                  *dfcode;               /* Compiled display filter program */
   gchar                      *dfilter;              /* Display filter string */
+  gchar                      *rescan_dfilter;       /* Display filter every frame's passed_dfilter was computed with, if known */
   gboolean                    redissecting;         /* TRUE if currently redissecting (cf_redissect_packets) */
   gboolean                    read_lock;            /* TRUE if currently processing a file (cf_read) */
   rescan_type                 redissection_queued;  /* Queued redissection type. */
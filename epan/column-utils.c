@@ -430,16 +430,27 @@ col_append_str_uint(column_info *cinfo, const gint col, const gchar *abbrev, gui
   col_append_lstr(cinfo, col, sep ? sep : "", abbrev, "=", buf, COL_ADD_LSTR_TERMINATOR);
 }
 
+/* Formats "name(port)" or "port" without going through the printf family;
+ * this is called for (nearly) every TCP/UDP/SCTP packet. */
 static inline void
 col_snprint_port(gchar *buf, size_t buf_siz, port_type typ, guint16 val)
 {
   const char *str;
+  char        num[6];
+  size_t      pos;
 
+  guint32_to_str_buf(val, num, sizeof(num));
   if (gbl_resolv_flags.transport_name &&
         (str = try_serv_name_lookup(typ, val)) != NULL) {
-    snprintf(buf, buf_siz, "%s(%"G_GUINT16_FORMAT")", str, val);
+    pos = g_strlcpy(buf, str, buf_siz);
+    if (pos < buf_siz)
+      pos += g_strlcpy(&buf[pos], "(", buf_siz - pos);
+    if (pos < buf_siz)
+      pos += g_strlcpy(&buf[pos], num, buf_siz - pos);
+    if (pos < buf_siz)
+      g_strlcpy(&buf[pos], ")", buf_siz - pos);
   } else {
-    snprintf(buf, buf_siz, "%"G_GUINT16_FORMAT, val);
+    g_strlcpy(buf, num, buf_siz);
   }
 }
 
@@ -488,9 +499,11 @@ col_do_append_fstr(column_info *cinfo, const int el, const char *separator, cons
 
       /*
        * If we have a separator, append it if the column isn't empty.
+       * We already know where the end of the string is, so copy rather
+       * than concatenate.
        */
-      if (sep_len != 0 && len != 0) {
-        g_strlcat(col_item->col_buf, separator, max_len);
+      if (sep_len != 0 && len != 0 && len < max_len) {
+        g_strlcpy(&col_item->col_buf[len], separator, max_len - len);
         len += sep_len;
       }
 
@@ -819,17 +832,20 @@ col_do_append_str(column_info *cinfo, const gint el, const gchar* separator,
        */
       COL_CHECK_APPEND(col_item, max_len);
 
-      len = col_item->col_buf[0];
+      len = strlen(col_item->col_buf);
 
       /*
        * If we have a separator, append it if the column isn't empty.
+       * Keep track of the end of the string ourselves instead of having
+       * each g_strlcat() look for it again.
        */
       if (separator != NULL) {
-        if (len != 0) {
-          g_strlcat(col_item->col_buf, separator, max_len);
+        if (len != 0 && len < max_len) {
+          len += g_strlcpy(&col_item->col_buf[len], separator, max_len - len);
         }
       }
-      g_strlcat(col_item->col_buf, str, max_len);
+      if (len < max_len)
+        g_strlcpy(&col_item->col_buf[len], str, max_len - len);
     }
   }
 }
@@ -1957,18 +1973,17 @@ col_set_addr(packet_info *pinfo, const int col, const address *addr, const gbool
 
 /* ------------------------ */
 static void
-col_set_port(packet_info *pinfo, const int col, const gboolean is_res, const gboolean is_src, const gboolean fill_col_exprs _U_)
+col_set_port(packet_info *pinfo, const int col, const gboolean is_res, const gboolean is_src, const gboolean fill_col_exprs)
 {
   guint32 port;
   col_item_t* col_item = &pinfo->cinfo->columns[col];
+  const char *expr = NULL;
 
   if (is_src)
     port = pinfo->srcport;
   else
     port = pinfo->destport;
 
-  /* TODO: Use fill_col_exprs */
-
   switch (pinfo->ptype) {
   case PT_SCTP:
     if (is_res)
@@ -1978,72 +1993,72 @@ col_set_port(packet_info *pinfo, const int col, const gboolean is_res, const gbo
     break;
 
   case PT_TCP:
-    guint32_to_str_buf(port, pinfo->cinfo->col_expr.col_expr_val[col], COL_MAX_LEN);
     if (is_res)
       g_strlcpy(col_item->col_buf, tcp_port_to_display(pinfo->pool, port), COL_MAX_LEN);
     else
-      g_strlcpy(col_item->col_buf, pinfo->cinfo->col_expr.col_expr_val[col], COL_MAX_LEN);
-    if (is_src)
-      pinfo->cinfo->col_expr.col_expr[col] = "tcp.srcport";
-    else
-      pinfo->cinfo->col_expr.col_expr[col] = "tcp.dstport";
+      guint32_to_str_buf(port, col_item->col_buf, COL_MAX_LEN);
+    expr = is_src ? "tcp.srcport" : "tcp.dstport";
     break;
 
   case PT_UDP:
-    guint32_to_str_buf(port, pinfo->cinfo->col_expr.col_expr_val[col], COL_MAX_LEN);
     if (is_res)
       g_strlcpy(col_item->col_buf, udp_port_to_display(pinfo->pool, port), COL_MAX_LEN);
     else
-      g_strlcpy(col_item->col_buf, pinfo->cinfo->col_expr.col_expr_val[col], COL_MAX_LEN);
-    if (is_src)
-      pinfo->cinfo->col_expr.col_expr[col] = "udp.srcport";
-    else
-      pinfo->cinfo->col_expr.col_expr[col] = "udp.dstport";
+      guint32_to_str_buf(port, col_item->col_buf, COL_MAX_LEN);
+    expr = is_src ? "udp.srcport" : "udp.dstport";
     break;
 
   case PT_DDP:
-    if (is_src)
-      pinfo->cinfo->col_expr.col_expr[col] = "ddp.src_socket";
-    else
-      pinfo->cinfo->col_expr.col_expr[col] = "ddp.dst_socket";
-    guint32_to_str_buf(port, pinfo->cinfo->col_expr.col_expr_val[col], COL_MAX_LEN);
-    g_strlcpy(col_item->col_buf, pinfo->cinfo->col_expr.col_expr_val[col], COL_MAX_LEN);
+    guint32_to_str_buf(port, col_item->col_buf, COL_MAX_LEN);
+    expr = is_src ? "ddp.src_socket" : "ddp.dst_socket";
     break;
 
   case PT_IPX:
     /* XXX - resolve IPX socket numbers */
-    snprintf(col_item->col_buf, COL_MAX_LEN, "0x%04x", port);
-    g_strlcpy(pinfo->cinfo->col_expr.col_expr_val[col], col_item->col_buf,COL_MAX_LEN);
-    if (is_src)
-      pinfo->cinfo->col_expr.col_expr[col] = "ipx.src.socket";
-    else
-      pinfo->cinfo->col_expr.col_expr[col] = "ipx.dst.socket";
+    col_item->col_buf[0] = '0';
+    col_item->col_buf[1] = 'x';
+    *word_to_hex(&col_item->col_buf[2], (guint16)port) = '\0';
+    expr = is_src ? "ipx.src.socket" : "ipx.dst.socket";
     break;
 
   case PT_IDP:
     /* XXX - resolve IDP socket numbers */
-    snprintf(col_item->col_buf, COL_MAX_LEN, "0x%04x", port);
-    g_strlcpy(pinfo->cinfo->col_expr.col_expr_val[col], col_item->col_buf,COL_MAX_LEN);
-    if (is_src)
-      pinfo->cinfo->col_expr.col_expr[col] = "idp.src.socket";
-    else
-      pinfo->cinfo->col_expr.col_expr[col] = "idp.dst.socket";
+    col_item->col_buf[0] = '0';
+    col_item->col_buf[1] = 'x';
+    *word_to_hex(&col_item->col_buf[2], (guint16)port) = '\0';
+    expr = is_src ? "idp.src.socket" : "idp.dst.socket";
     break;
 
   case PT_USB:
     /* XXX - resolve USB endpoint numbers */
-    snprintf(col_item->col_buf, COL_MAX_LEN, "0x%08x", port);
-    g_strlcpy(pinfo->cinfo->col_expr.col_expr_val[col], col_item->col_buf,COL_MAX_LEN);
-    if (is_src)
-      pinfo->cinfo->col_expr.col_expr[col] = "usb.src.endpoint";
-    else
-      pinfo->cinfo->col_expr.col_expr[col] = "usb.dst.endpoint";
+    col_item->col_buf[0] = '0';
+    col_item->col_buf[1] = 'x';
+    *dword_to_hex(&col_item->col_buf[2], port) = '\0';
+    expr = is_src ? "usb.src.endpoint" : "usb.dst.endpoint";
     break;
 
   default:
     break;
   }
   col_item->col_data = col_item->col_buf;
+
+  /* Only build the filter expression if someone is going to use it. */
+  if (expr == NULL || !fill_col_exprs)
+    return;
+
+  pinfo->cinfo->col_expr.col_expr[col] = expr;
+  switch (pinfo->ptype) {
+  case PT_TCP:
+  case PT_UDP:
+  case PT_DDP:
+    guint32_to_str_buf(port, pinfo->cinfo->col_expr.col_expr_val[col], COL_MAX_LEN);
+    break;
+
+  default:
+    /* Hex formatted; the column text is the filter value. */
+    g_strlcpy(pinfo->cinfo->col_expr.col_expr_val[col], col_item->col_buf, COL_MAX_LEN);
+    break;
+  }
 }
 
 gboolean
@@ -15,6 +15,7 @@
 #include "packet.h"
 #include "to_str.h"
 #include "conversation.h"
+#include "prefs.h"
 
 /* define DEBUG_CONVERSATION for pretty debug printing */
 /* #define DEBUG_CONVERSATION */
@@ -65,6 +66,25 @@ static wmem_map_t *conversation_hashtable_no_addr2_or_port2 = NULL;
 
 static guint32 new_index;
 
+/*
+ * Conversations ordered from least to most recently active, kept only
+ * while the "conversation_limit" or "conversation_idle_timeout"
+ * preferences are set.
+ */
+static conversation_t *idle_head = NULL;
+static conversation_t *idle_tail = NULL;
+static guint32 live_count;
+static guint64 evicted_count;
+static time_t current_time;
+static guint32 current_frame;	/* frame in its first pass, see conversation_evict_idle() */
+
+typedef struct {
+	int proto;
+	conversation_evict_func func;
+} conversation_evict_callback_t;
+
+static GSList *evict_callbacks = NULL;
+
 /*
  * Placeholder for address-less conversations.
  */
@@ -480,6 +500,62 @@ void conversation_epan_reset(void)
 	 * Start the conversation indices over at 0.
 	 */
 	new_index = 0;
+
+	/*
+	 * The conversations themselves were in the file scope.
+	 */
+	idle_head = idle_tail = NULL;
+	live_count = 0;
+	evicted_count = 0;
+	current_time = 0;
+	current_frame = 0;
+}
+
+gboolean
+conversation_eviction_enabled(void)
+{
+	return prefs.conversation_limit != 0 || prefs.conversation_idle_timeout != 0;
+}
+
+static void
+conversation_idle_unlink(conversation_t *conv)
+{
+	if (conv->idle_prev)
+		conv->idle_prev->idle_next = conv->idle_next;
+	else if (idle_head == conv)
+		idle_head = conv->idle_next;
+	else
+		return;	/* not in the list */
+
+	if (conv->idle_next)
+		conv->idle_next->idle_prev = conv->idle_prev;
+	else
+		idle_tail = conv->idle_prev;
+
+	conv->idle_prev = conv->idle_next = NULL;
+}
+
+/*
+ * Move a conversation to the most recently active end of the list.
+ * Templates are never evicted, as they are not tied to a single flow.
+ */
+static void
+conversation_touch(conversation_t *conv)
+{
+	if (!conversation_eviction_enabled() || (conv->options & CONVERSATION_TEMPLATE))
+		return;
+
+	conv->last_active = current_time;
+	if (idle_tail == conv)
+		return;
+
+	conversation_idle_unlink(conv);
+	conv->idle_prev = idle_tail;
+	if (idle_tail)
+		idle_tail->idle_next = conv;
+	else
+		idle_head = conv;
+	idle_tail = conv;
 }
 
 /*
@@ -756,6 +832,9 @@ conversation_new(const guint32 setup_frame, const address *addr1, const address
 	conversation_insert_into_hashtable(hashtable, conversation);
 	DENDENT();
 
+	live_count++;
+	conversation_touch(conversation);
+
 	return conversation;
 }
 
@@ -1282,6 +1361,10 @@ find_conversation(const guint32 frame_num, const address *addr_a, const address
 	conversation = NULL;
 
 end:
+	/* Any lookup while dissecting a frame the first time counts as activity. */
+	if (conversation && frame_num == current_frame)
+		conversation_touch(conversation);
+
 	DINSTR(wmem_free(NULL, addr_a_str));
 	DINSTR(wmem_free(NULL, addr_b_str));
 	return conversation;
@@ -1482,6 +1565,120 @@ find_conversation_pinfo(packet_info *pinfo, const guint options)
 	return conv;
 }
 
+static wmem_map_t *
+conversation_hashtable_for_options(const guint options)
+{
+	if (options & NO_ADDR2) {
+		if (options & (NO_PORT2|NO_PORT2_FORCE))
+			return conversation_hashtable_no_addr2_or_port2;
+		return conversation_hashtable_no_addr2;
+	}
+	if (options & (NO_PORT2|NO_PORT2_FORCE))
+		return conversation_hashtable_no_port2;
+	return conversation_hashtable_exact;
+}
+
+static gboolean
+conversation_evict_proto_data(const void *key, void *value, void *userdata)
+{
+	conversation_t *conv = (conversation_t *)userdata;
+	int proto = GPOINTER_TO_INT(key);
+
+	for (GSList *cur = evict_callbacks; cur; cur = g_slist_next(cur)) {
+		conversation_evict_callback_t *cb = (conversation_evict_callback_t *)cur->data;
+
+		if (cb->proto == proto)
+			cb->func(conv, value);
+	}
+	return FALSE;
+}
+
+/*
+ * Remove a conversation from its hash table and free it along with its
+ * key. Registered protocols get a chance to free their data first.
+ */
+static void
+conversation_evict(conversation_t *conv)
+{
+	wmem_map_t *hashtable = conversation_hashtable_for_options(conv->options);
+	conversation_key_t key = conv->key_ptr;
+
+	conversation_idle_unlink(conv);
+
+	if (wmem_map_lookup(hashtable, key) == conv && conv->next == NULL) {
+		/* The only conversation with this key; the key goes with it. */
+		wmem_map_remove(hashtable, key);
+	} else {
+		conversation_remove_from_hashtable(hashtable, conv);
+		/* The map may still refer to our key for the new chain head. */
+		if (wmem_map_lookup(hashtable, key) != NULL) {
+			conversation_t *head = (conversation_t *)wmem_map_lookup(hashtable, key);
+
+			if (head != conv) {
+				wmem_map_remove(hashtable, key);
+				wmem_map_insert(hashtable, head->key_ptr, head);
+			}
+		}
+	}
+
+	if (conv->data_list) {
+		if (evict_callbacks)
+			wmem_tree_foreach(conv->data_list, conversation_evict_proto_data, conv);
+		wmem_tree_destroy(conv->data_list, FALSE, FALSE);
+	}
+	wmem_tree_destroy(conv->dissector_tree, FALSE, FALSE);
+	packet_forget_conversation(conv);
+
+	free_address_wmem(wmem_file_scope(), &key->addr1);
+	free_address_wmem(wmem_file_scope(), &key->addr2);
+	wmem_free(wmem_file_scope(), key);
+	wmem_free(wmem_file_scope(), conv);
+
+	live_count--;
+	evicted_count++;
+}
+
+void
+conversation_evict_idle(const packet_info *pinfo)
+{
+	current_time = pinfo->abs_ts.secs;
+	current_frame = pinfo->num;
+
+	if (!conversation_eviction_enabled())
+		return;
+
+	if (prefs.conversation_idle_timeout != 0) {
+		while (idle_head && current_time - idle_head->last_active > (time_t)prefs.conversation_idle_timeout)
+			conversation_evict(idle_head);
+	}
+	if (prefs.conversation_limit != 0) {
+		while (idle_head && live_count > prefs.conversation_limit)
+			conversation_evict(idle_head);
+	}
+}
+
+void
+conversation_register_evict_callback(const int proto, conversation_evict_func func)
+{
+	conversation_evict_callback_t *cb = g_new(conversation_evict_callback_t, 1);
+
+	cb->proto = proto;
+	cb->func = func;
+	evict_callbacks = g_slist_prepend(evict_callbacks, cb);
+}
+
+guint32
+conversation_count_live(void)
+{
+	return live_count;
+}
+
+guint64
+conversation_count_evicted(void)
+{
+	return evicted_count;
+}
+
 /*  A helper function that calls find_conversation() and, if a conversation is
  *  not found, calls conversation_new().
  *  The frame number and addresses are taken from pinfo.
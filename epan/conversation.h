@@ -98,6 +98,9 @@ typedef struct conversation {
 	wmem_tree_t *dissector_tree;	/** tree containing protocol dissector client associated with conversation */
 	guint	options;		/** wildcard flags */
 	conversation_key_t key_ptr;	/** pointer to the key for this conversation */
+	struct conversation *idle_prev;	/** less recently active conversation, when eviction is enabled */
+	struct conversation *idle_next;	/** more recently active conversation, when eviction is enabled */
+	time_t	last_active;		/** time of the last frame that looked up this conversation */
 } conversation_t;
 
 
@@ -119,6 +122,53 @@ extern void conversation_init(void);
  */
 extern void conversation_epan_reset(void);
 
+/**
+ * Called with the first pass of each frame. If the "conversation_limit" or
+ * "conversation_idle_timeout" preferences are set, evicts the least recently
+ * active conversations until both limits are met.
+ *
+ * Eviction frees the conversation, so it is only safe when frames are
+ * dissected once, e.g. when capturing with TShark without -2.
+ */
+extern void conversation_evict_idle(const packet_info *pinfo);
+
+/**
+ * Whether the "conversation_limit" or "conversation_idle_timeout"
+ * preferences are set, i.e. whether conversations may be evicted.
+ */
+WS_DLL_PUBLIC gboolean conversation_eviction_enabled(void);
+
+/**
+ * Called for each conversation being evicted which has data for the
+ * protocol the callback was registered for.
+ *
+ * The memory of an evicted conversation is reused, so a table which is
+ * keyed on a conversation_t pointer must drop the conversation's entries
+ * from this callback; otherwise a later conversation allocated at the same
+ * address inherits them. DCE/RPC does so. The request/response tables of
+ * H.225 RAS, MGCP and RADIUS are still keyed on the conversation pointer
+ * and may mismatch transactions of a new conversation with those of an
+ * evicted one.
+ */
+typedef void (*conversation_evict_func)(conversation_t *conv, void *proto_data);
+
+/**
+ * Register a function which releases a protocol's conversation data when
+ * the conversation is evicted. The data is removed from the conversation
+ * afterwards.
+ */
+WS_DLL_PUBLIC void conversation_register_evict_callback(const int proto, conversation_evict_func func);
+
+/**
+ * Number of conversations created and not evicted since the file was opened.
+ */
+WS_DLL_PUBLIC guint32 conversation_count_live(void);
+
+/**
+ * Number of conversations evicted since the file was opened.
+ */
+WS_DLL_PUBLIC guint64 conversation_count_evicted(void);
+
 /*
  * Given two address/port pairs for a packet, create a new conversation
  * to contain packets between those address/port pairs.
@@ -427,6 +427,37 @@ dfilter_has_interesting_fields(const dfilter_t *df)
 	return (df->num_interesting_fields > 0);
 }
 
+/*
+ * "&&" (or "and") has the lowest precedence in the grammar, so "base"
+ * followed by a top-level "&&" can only match what "base" matches.
+ */
+gboolean
+dfilter_text_refines(const gchar *text, const gchar *base)
+{
+	size_t len;
+	const gchar *p;
+
+	if (!text || !base)
+		return FALSE;
+
+	len = strlen(base);
+	if (len == 0 || strncmp(text, base, len) != 0)
+		return FALSE;
+
+	p = text + len;
+	while (g_ascii_isspace(*p))
+		p++;
+
+	if (p[0] == '&' && p[1] == '&')
+		return TRUE;
+
+	if (p != text + len && strncmp(p, "and", 3) == 0 &&
+		(g_ascii_isspace(p[3]) || p[3] == '(' || p[3] == '!'))
+		return TRUE;
+
+	return FALSE;
+}
+
 GPtrArray *
 dfilter_deprecated_tokens(dfilter_t *df) {
 	if (df->deprecated && df->deprecated->len > 0) {
@@ -72,6 +72,13 @@ dfilter_prime_proto_tree(const dfilter_t *df, proto_tree *tree);
 gboolean
 dfilter_has_interesting_fields(const dfilter_t *df);
 
+/* Check whether filter "text" is filter "base" followed by a top-level
+ * "&&", so that only packets matching "base" can match "text". This is
+ * purely textual; FALSE doesn't mean "text" isn't narrower. */
+WS_DLL_PUBLIC
+gboolean
+dfilter_text_refines(const gchar *text, const gchar *base);
+
 WS_DLL_PUBLIC
 GPtrArray *
 dfilter_deprecated_tokens(dfilter_t *df);
@@ -719,6 +719,53 @@ typedef struct _dcerpc_auth_context {
     gboolean        hdr_signing;
 } dcerpc_auth_context;
 
+/*
+ * The bind, auth and call tables are keyed on the conversation pointer.
+ * When conversations are evicted, the keys added for a conversation are
+ * recorded in its DCERPC conversation data, so that they can be removed
+ * from the tables before a new conversation reuses the same address.
+ */
+typedef struct _dcerpc_conv_key {
+    wmem_map_t *table;
+    const void *key;
+} dcerpc_conv_key;
+
+static void
+dcerpc_conv_track_key(conversation_t *conv, wmem_map_t *table, const void *key)
+{
+    wmem_list_t     *keys;
+    dcerpc_conv_key *entry;
+
+    if (!conversation_eviction_enabled())
+        return;
+
+    keys = (wmem_list_t *)conversation_get_proto_data(conv, proto_dcerpc);
+    if (!keys) {
+        keys = wmem_list_new(wmem_file_scope());
+        conversation_add_proto_data(conv, proto_dcerpc, keys);
+    }
+    entry = wmem_new(wmem_file_scope(), dcerpc_conv_key);
+    entry->table = table;
+    entry->key = key;
+    wmem_list_append(keys, entry);
+}
+
+static void
+dcerpc_conversation_evicted(conversation_t *conv _U_, void *proto_data)
+{
+    wmem_list_t       *keys = (wmem_list_t *)proto_data;
+    wmem_list_frame_t *frame;
+
+    for (frame = wmem_list_head(keys); frame; frame = wmem_list_frame_next(frame)) {
+        dcerpc_conv_key *entry = (dcerpc_conv_key *)wmem_list_frame_data(frame);
+
+        /* The values may still be referenced from dcerpc_matched. */
+        wmem_map_remove(entry->table, entry->key);
+        wmem_free(wmem_file_scope(), entry);
+    }
+    wmem_destroy_list(keys);
+}
+
 /* Extra data for DCERPC handling and tracking of context ids */
 typedef struct _dcerpc_decode_as_data {
     guint16 dcectxid;             /**< Context ID (DCERPC-specific) */
@@ -794,6 +841,7 @@ dcerpc_add_conv_to_bind_table(decode_dcerpc_bind_values_t *binding)
 
     /* add this entry to the bind table */
     wmem_map_insert(dcerpc_binds, key, bind_value);
+    dcerpc_conv_track_key(conv, dcerpc_binds, key);
 
     return bind_value;
 
@@ -3810,6 +3858,7 @@ static dcerpc_auth_context *find_or_create_dcerpc_auth_context(packet_info *pinf
 
     *auth_value = auth_key;
     wmem_map_insert(dcerpc_auths, auth_value, auth_value);
+    dcerpc_conv_track_key(auth_value->conv, dcerpc_auths, auth_value);
 
 return_value:
     if (pinfo->fd->num < auth_value->first_frame) {
@@ -4167,6 +4216,7 @@ dissect_dcerpc_cn_bind(tvbuff_t *tvb, gint offset, packet_info *pinfo,
 
             /* add this entry to the bind table */
             wmem_map_insert(dcerpc_binds, key, value);
+            dcerpc_conv_track_key(key->conv, dcerpc_binds, key);
         }
 
         if (i > 0)
@@ -4679,6 +4729,7 @@ dissect_dcerpc_cn_rqst(tvbuff_t *tvb, gint offset, packet_info *pinfo,
                     }
 
                     wmem_map_insert(dcerpc_cn_calls, call_key, call_value);
+                    dcerpc_conv_track_key(call_key->conv, dcerpc_cn_calls, call_key);
 
                     new_matched_key = wmem_new(wmem_file_scope(), dcerpc_matched_key);
                     *new_matched_key = matched_key;
@@ -6228,6 +6279,7 @@ dissect_dcerpc_dg_rqst(tvbuff_t *tvb, int offset, packet_info *pinfo,
         call_value->flags = 0;
 
         wmem_map_insert(dcerpc_dg_calls, call_key, call_value);
+        dcerpc_conv_track_key(call_key->conv, dcerpc_dg_calls, call_key);
 
         new_matched_key = wmem_new(wmem_file_scope(), dcerpc_matched_key);
         new_matched_key->frame = pinfo->num;
@@ -7181,6 +7233,7 @@ proto_register_dcerpc(void)
     dcerpc_matched = wmem_map_new_autoreset(wmem_epan_scope(), wmem_file_scope(), dcerpc_matched_hash, dcerpc_matched_equal);
 
     register_init_routine(decode_dcerpc_inject_bindings);
+    conversation_register_evict_callback(proto_dcerpc, dcerpc_conversation_evicted);
 
     dcerpc_module = prefs_register_protocol(proto_dcerpc, NULL);
     prefs_register_bool_preference(dcerpc_module,
@@ -1348,6 +1348,67 @@ qname_labels_count(const gchar* name, gint name_len)
     return labels;
 }
 
+/* Names already expanded in the DNS message being dissected, keyed by the
+ * offset of their first label or pointer. Compression pointers usually refer
+ * to a name (or the tail of one) that was expanded before, so its suffix can
+ * be reused instead of walking the labels again.
+ */
+typedef struct {
+  const gchar *name;
+  gint         name_len;
+  int          len;     /* bytes consumed at this offset, -1 if not known */
+} dns_name_cache_entry_t;
+
+typedef struct {
+  tvbuff_t    *tvb;
+  int          dns_data_offset;
+  wmem_map_t  *names;
+} dns_name_cache_t;
+
+static dns_name_cache_t *dns_name_cache = NULL;
+
+/* Labels recorded per name for the cache, a name has at most 127. */
+#define DNS_NAME_CACHE_MAX_LABELS 128
+
+static gboolean
+dns_name_cache_free_cb(wmem_allocator_t *allocator _U_, wmem_cb_event_t event _U_, void *user_data _U_)
+{
+  dns_name_cache = NULL;
+  return FALSE;
+}
+
+static dns_name_cache_t *
+dns_name_cache_get(tvbuff_t *tvb, int dns_data_offset)
+{
+  if (dns_name_cache && dns_name_cache->tvb == tvb &&
+      dns_name_cache->dns_data_offset == dns_data_offset) {
+    return dns_name_cache;
+  }
+  if (!dns_name_cache) {
+    wmem_register_callback(wmem_packet_scope(), dns_name_cache_free_cb, NULL);
+  }
+  dns_name_cache = wmem_new(wmem_packet_scope(), dns_name_cache_t);
+  dns_name_cache->tvb = tvb;
+  dns_name_cache->dns_data_offset = dns_data_offset;
+  dns_name_cache->names = wmem_map_new(wmem_packet_scope(), g_direct_hash, g_direct_equal);
+  return dns_name_cache;
+}
+
+static void
+dns_name_cache_add(dns_name_cache_t *cache, int offset, const gchar *name, gint name_len, int len)
+{
+  dns_name_cache_entry_t *entry;
+
+  if (wmem_map_contains(cache->names, GINT_TO_POINTER(offset))) {
+    return;
+  }
+  entry = wmem_new(wmem_packet_scope(), dns_name_cache_entry_t);
+  entry->name = name;
+  entry->name_len = name_len;
+  entry->len = len;
+  wmem_map_insert(cache->names, GINT_TO_POINTER(offset), entry);
+}
+
 /* This function returns the number of bytes consumed and the expanded string
  * in *name.
  * The string is allocated with wmem_packet_scope scope and does not need to be freed.
@@ -1358,21 +1419,42 @@ expand_dns_name(tvbuff_t *tvb, int offset, int max_len, int dns_data_offset,
     const gchar **name, gint* name_len)
 {
   int     start_offset    = offset;
-  gchar  *np;
+  gchar   buf[MAX_DNAME_LEN];
+  gchar  *np              = buf;
+  gchar  *out;
   int     len             = -1;
   int     pointers_count  = 0;
   int     component_len;
   int     indir_offset;
   int     maxname;
+  dns_name_cache_t       *cache = NULL;
+  dns_name_cache_entry_t *entry;
+  /* Where each label starts, in the message and in the expanded name. */
+  struct {
+    int  offset;
+    int  pos;
+    gint name_len;
+    gboolean before_pointer;
+  } labels[DNS_NAME_CACHE_MAX_LABELS];
+  int     nlabels         = 0;
+  int     i;
 
   const int min_len = 1;        /* Minimum length of encoded name (for root) */
         /* If we're about to return a value (probably negative) which is less
          * than the minimum length, we're looking at bad data and we're liable
          * to put the dissector into a loop.  Instead we throw an exception */
 
+  if (max_len == 0) {
+    cache = dns_name_cache_get(tvb, dns_data_offset);
+    entry = (dns_name_cache_entry_t *)wmem_map_lookup(cache->names, GINT_TO_POINTER(offset));
+    if (entry && entry->len >= 0) {
+      *name = entry->name;
+      *name_len = entry->name_len;
+      return entry->len;
+    }
+  }
+
   maxname = MAX_DNAME_LEN;
-  np=(gchar *)wmem_alloc(wmem_packet_scope(), maxname);
-  *name=np;
   (*name_len) = 0;
 
   for (;;) {
@@ -1388,7 +1470,7 @@ expand_dns_name(tvbuff_t *tvb, int offset, int max_len, int dns_data_offset,
 
       case 0x00:
         /* Label */
-        if (np != *name) {
+        if (np != buf) {
           /* Not the first component - put in a '.'. */
           if (maxname > 0) {
             *np++ = '.';
@@ -1399,6 +1481,13 @@ expand_dns_name(tvbuff_t *tvb, int offset, int max_len, int dns_data_offset,
         else {
           maxname--;
         }
+        if (cache && nlabels < DNS_NAME_CACHE_MAX_LABELS) {
+          labels[nlabels].offset = offset - 1;
+          labels[nlabels].pos = (int)(np - buf);
+          labels[nlabels].name_len = *name_len;
+          labels[nlabels].before_pointer = len < 0;
+          nlabels++;
+        }
         while (component_len > 0) {
           if (max_len && offset - start_offset > max_len - 1) {
             THROW(ReportedBoundsError);
@@ -1428,6 +1517,10 @@ expand_dns_name(tvbuff_t *tvb, int offset, int max_len, int dns_data_offset,
             offset++;
             label_len = (bit_count - 1) / 8 + 1;
 
+            /* name_len does not count the printed label, do not cache
+               this name. */
+            cache = NULL;
+
             if (maxname > 0) {
               print_len = g_snprintf(np, maxname, "\\[x");
               if (print_len <= maxname) {
@@ -1511,24 +1604,52 @@ expand_dns_name(tvbuff_t *tvb, int offset, int max_len, int dns_data_offset,
           return len;
         }
 
+        /* The rest of the name was expanded before and fits: done. */
+        entry = cache ? (dns_name_cache_entry_t *)wmem_map_lookup(cache->names, GINT_TO_POINTER(indir_offset)) : NULL;
+        if (entry && maxname > 0 && entry->name_len > 0 && entry->name_len <= maxname - 1) {
+          if (np != buf) {
+            *np++ = '.';
+            (*name_len)++;
+          }
+          maxname--;
+          memcpy(np, entry->name, entry->name_len);
+          np += entry->name_len;
+          (*name_len) += entry->name_len;
+          maxname -= entry->name_len;
+          goto expanded;
+        }
+
         offset = indir_offset;
         break;   /* now continue processing from there */
     }
   }
 
-  // Do we have space for the terminating 0?
-  if (maxname > 0) {
-    *np = '\0';
+expanded:
+  /* If "len" is negative, we haven't seen a pointer, and thus haven't
+     set the length, so set it. */
+  if (len < 0) {
+    len = offset - start_offset;
   }
-  else {
+
+  // Do we have space for the terminating 0?
+  if (maxname <= 0) {
     *name="<Name too long>";
     *name_len = (guint)strlen(*name);
+    return len;
   }
 
-  /* If "len" is negative, we haven't seen a pointer, and thus haven't
-     set the length, so set it. */
-  if (len < 0) {
-    len = offset - start_offset;
+  out = (gchar *)wmem_alloc(wmem_packet_scope(), np - buf + 1);
+  memcpy(out, buf, np - buf);
+  out[np - buf] = '\0';
+  *name = out;
+
+  if (cache) {
+    for (i = 0; i < nlabels; i++) {
+      dns_name_cache_add(cache, labels[i].offset, out + labels[i].pos,
+          *name_len - labels[i].name_len,
+          labels[i].before_pointer ? start_offset + len - labels[i].offset : -1);
+    }
+    dns_name_cache_add(cache, start_offset, out, *name_len, len);
   }
 
   return len;
@@ -388,6 +388,7 @@ proto_register_ethertype(void)
 	/* subdissector code */
 	ethertype_dissector_table = register_dissector_table("ethertype",
 								"Ethertype", proto_ethertype, FT_UINT16, BASE_HEX);
+	dissector_table_use_flat_lookup(ethertype_dissector_table);
 	register_capture_dissector_table("ethertype", "Ethertype");
 
 	register_decode_as(&ethertype_da);
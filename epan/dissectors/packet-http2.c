@@ -519,8 +519,6 @@ static const fragment_items http2_body_fragment_items = {
    wmem_map_t to reuse its memory region when we see the same header
    field next time. */
 static wmem_map_t *http2_hdrcache_map = NULL;
-/* Header name_length + name + value_length + value */
-static char *http2_header_pstr = NULL;
 #endif
 
 #ifdef HAVE_NGHTTP2
@@ -1138,7 +1136,6 @@ hd_inflate_del_cb(wmem_allocator_t *allocator _U_, wmem_cb_event_t event _U_, vo
 {
     nghttp2_hd_inflate_del((nghttp2_hd_inflater*)user_data);
     http2_hdrcache_map = NULL;
-    http2_header_pstr = NULL;
 
     return FALSE;
 }
@@ -1460,15 +1457,13 @@ process_http2_header_repr_info(wmem_array_t *headers,
 
         if(header_repr_info->complete) {
             if(header_repr_info->type == HTTP2_HD_HEADER_TABLE_SIZE_UPDATE) {
-                http2_header_t *out;
+                http2_header_t out;
 
-                out = wmem_new(wmem_file_scope(), http2_header_t);
+                out.type = header_repr_info->type;
+                out.length = i - start;
+                out.table.header_table_size = header_repr_info->integer;
 
-                out->type = header_repr_info->type;
-                out->length = i - start;
-                out->table.header_table_size = header_repr_info->integer;
-
-                wmem_array_append(headers, out, 1);
+                wmem_array_append_one(headers, out);
 
                 reset_http2_header_repr_info(header_repr_info);
                 /* continue to decode header table size update or
@@ -1775,6 +1770,9 @@ inflate_http2_header_block(tvbuff_t *tvb, packet_info *pinfo, guint offset, prot
     wmem_list_t *header_list;
     wmem_array_t *headers;
     guint i;
+    /* Header name_length + name + value_length + value */
+    char *header_pstr = NULL;
+    guint header_pstr_size = 0;
     const gchar *method_header_value = NULL;
     const gchar *path_header_value = NULL;
     http2_header_stream_info_t* header_stream_info;
@@ -1809,7 +1807,9 @@ inflate_http2_header_block(tvbuff_t *tvb, packet_info *pinfo, guint offset, prot
 
         final = flags & HTTP2_FLAGS_END_HEADERS;
 
-        headers = wmem_array_sized_new(wmem_file_scope(), sizeof(http2_header_t), 16);
+        /* Decoded into packet scope first; only an array of the exact
+           size is kept per frame. */
+        headers = wmem_array_sized_new(wmem_packet_scope(), sizeof(http2_header_t), 16);
 
         for(;;) {
             nghttp2_nv nv;
@@ -1836,7 +1836,7 @@ inflate_http2_header_block(tvbuff_t *tvb, packet_info *pinfo, guint offset, prot
                 char *cached_pstr;
                 guint32 len;
                 guint datalen = (guint)(4 + nv.namelen + 4 + nv.valuelen);
-                http2_header_t *out;
+                http2_header_t out;
 
                 if (decompressed_bytes + datalen >= MAX_HTTP2_HEADER_SIZE) {
                     header_data->header_size_reached = decompressed_bytes;
@@ -1844,13 +1844,11 @@ inflate_http2_header_block(tvbuff_t *tvb, packet_info *pinfo, guint offset, prot
                     break;
                 }
 
-                out = wmem_new(wmem_file_scope(), http2_header_t);
-
-                out->type = header_repr_info->type;
-                out->length = rv;
-                out->table.data.idx = header_repr_info->integer;
+                out.type = header_repr_info->type;
+                out.length = rv;
+                out.table.data.idx = header_repr_info->integer;
 
-                out->table.data.datalen = datalen;
+                out.table.data.datalen = datalen;
                 decompressed_bytes += datalen;
 
                 /* Prepare buffer... with the following format
@@ -1858,30 +1856,32 @@ inflate_http2_header_block(tvbuff_t *tvb, packet_info *pinfo, guint offset, prot
                    name (string)
                    value length (uint32)
                    value (string)
-                */
-                http2_header_pstr = (char *)wmem_realloc(wmem_file_scope(), http2_header_pstr, out->table.data.datalen);
+                   It is only copied to file scope if this header field
+                   was not seen before. */
+                if (datalen > header_pstr_size) {
+                    header_pstr_size = MAX(datalen, 2 * header_pstr_size);
+                    header_pstr = (char *)wmem_realloc(wmem_packet_scope(), header_pstr, header_pstr_size);
+                }
 
                 /* nv.namelen and nv.valuelen are of size_t.  In order
                    to get length in 4 bytes, we have to copy it to
                    guint32. */
                 len = (guint32)nv.namelen;
-                phton32(&http2_header_pstr[0], len);
-                memcpy(&http2_header_pstr[4], nv.name, nv.namelen);
+                phton32(&header_pstr[0], len);
+                memcpy(&header_pstr[4], nv.name, nv.namelen);
 
                 len = (guint32)nv.valuelen;
-                phton32(&http2_header_pstr[4 + nv.namelen], len);
-                memcpy(&http2_header_pstr[4 + nv.namelen + 4], nv.value, nv.valuelen);
+                phton32(&header_pstr[4 + nv.namelen], len);
+                memcpy(&header_pstr[4 + nv.namelen + 4], nv.value, nv.valuelen);
 
-                cached_pstr = (char *)wmem_map_lookup(http2_hdrcache_map, http2_header_pstr);
-                if (cached_pstr) {
-                    out->table.data.data = cached_pstr;
-                } else {
-                    wmem_map_insert(http2_hdrcache_map, http2_header_pstr, http2_header_pstr);
-                    out->table.data.data = http2_header_pstr;
-                    http2_header_pstr = NULL;
+                cached_pstr = (char *)wmem_map_lookup(http2_hdrcache_map, header_pstr);
+                if (!cached_pstr) {
+                    cached_pstr = (char *)wmem_memdup(wmem_file_scope(), header_pstr, datalen);
+                    wmem_map_insert(http2_hdrcache_map, cached_pstr, cached_pstr);
                 }
+                out.table.data.data = cached_pstr;
 
-                wmem_array_append(headers, out, 1);
+                wmem_array_append_one(headers, out);
 
                 reset_http2_header_repr_info(header_repr_info);
             }
@@ -1895,6 +1895,15 @@ inflate_http2_header_block(tvbuff_t *tvb, packet_info *pinfo, guint offset, prot
             }
         }
 
+        {
+            wmem_array_t *decoded = headers;
+            guint count = wmem_array_get_count(decoded);
+
+            headers = wmem_array_sized_new(wmem_file_scope(), sizeof(http2_header_t), count);
+            if (count > 0) {
+                wmem_array_append(headers, wmem_array_get_raw(decoded), count);
+            }
+        }
         wmem_list_append(header_list, headers);
 
         if(!header_data->current) {
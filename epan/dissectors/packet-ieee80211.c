@@ -90,6 +90,13 @@ typedef struct {
   guint8 *keydata;
 } proto_eapol_keydata_t;
 
+typedef struct {
+  const DOT11DECRYPT_KEY_ITEM *used_key; /* shared by every payload it decrypted */
+  guint8 layer_num;
+  guint data_len;
+  guint8 *data;
+} proto_decrypted_payload_t;
+
 extern value_string_ext eap_type_vals_ext; /* from packet-eap.c */
 
 /* TUs are used a lot in 802.11 ... */
@@ -281,6 +288,12 @@ UAT_CSTRING_CB_DEF(uat_wep_key_records, string, uat_wep_key_record_t)
 /* Stuff for the WEP/WPA/WPA2 decoder */
 static gboolean enable_decryption = TRUE;
 
+/* Decrypted payloads kept for redissection, limit in MiB */
+static guint wlan_decrypt_cache_size = 64;
+static guint64 wlan_decrypt_cache_used = 0;
+/* One copy of each key that decrypted a kept payload */
+static wmem_map_t *wlan_decrypt_cache_keys = NULL;
+
 static void
 ieee_80211_add_tagged_parameters(tvbuff_t *tvb, int offset, packet_info *pinfo,
                                   proto_tree *tree, int tagged_parameters_len, int ftype,
@@ -357,6 +370,7 @@ typedef enum {
   RSNE_TAG_KEY,
   RDE_TAG_KEY,
   GTK_SUBELEM_KEY_LEN_KEY,
+  DECRYPTED_PAYLOAD_KEY,
 } wlan_proto_key_t;
 
 /* ************************************************************************* */
@@ -33623,52 +33637,92 @@ try_decrypt(tvbuff_t *tvb, packet_info *pinfo, guint offset, guint len,
             PDOT11DECRYPT_KEY_ITEM used_key)
 {
   const guint8      *enc_data;
-  tvbuff_t          *decr_tvb = NULL;
-  guint32            dec_caplen;
+  guint32            dec_caplen = 0;
   guchar             dec_data[DOT11DECRYPT_MAX_CAPLEN];
+  proto_decrypted_payload_t *payload = NULL;
+  guint8            *tmp;
 
   if (!enable_decryption)
     return NULL;
 
-  /* get the entire packet                                  */
-  enc_data = tvb_get_ptr(tvb, 0, len+offset);
+  if (pinfo->fd->visited) {
+    /* Reuse the payload decrypted in the first pass, if it was kept */
+    payload = (proto_decrypted_payload_t *)p_get_proto_data(wmem_file_scope(), pinfo, proto_wlan, DECRYPTED_PAYLOAD_KEY);
+    if (payload && payload->layer_num != pinfo->curr_layer_num) {
+      payload = NULL;
+    }
+  }
 
-  /* decrypt packet with Dot11Decrypt */
-  gint ret = Dot11DecryptDecryptPacket(&dot11decrypt_ctx, enc_data, offset, offset+len,
-                                       dec_data, &dec_caplen, used_key);
-  if (ret == DOT11DECRYPT_RET_SUCCESS) {
-    guint8 *tmp;
-    *algorithm=used_key->KeyType;
-    switch (*algorithm) {
-      case DOT11DECRYPT_KEY_TYPE_WEP:
-        *sec_trailer=DOT11DECRYPT_WEP_TRAILER;
-        break;
-      case DOT11DECRYPT_KEY_TYPE_CCMP:
-        *sec_trailer=DOT11DECRYPT_CCMP_TRAILER;
-        break;
-      case DOT11DECRYPT_KEY_TYPE_CCMP_256:
-        *sec_trailer = DOT11DECRYPT_CCMP_256_TRAILER;
-        break;
-      case DOT11DECRYPT_KEY_TYPE_GCMP:
-      case DOT11DECRYPT_KEY_TYPE_GCMP_256:
-        *sec_trailer = DOT11DECRYPT_GCMP_TRAILER;
-        break;
-      case DOT11DECRYPT_KEY_TYPE_TKIP:
-        *sec_trailer=DOT11DECRYPT_TKIP_TRAILER;
-        break;
-      default:
-        return NULL;
+  if (payload) {
+    *used_key = *payload->used_key;
+  } else {
+    /* get the entire packet                                  */
+    enc_data = tvb_get_ptr(tvb, 0, len+offset);
+
+    /* decrypt packet with Dot11Decrypt */
+    gint ret = Dot11DecryptDecryptPacket(&dot11decrypt_ctx, enc_data, offset, offset+len,
+                                         dec_data, &dec_caplen, used_key);
+    if (ret != DOT11DECRYPT_RET_SUCCESS) {
+      return NULL;
     }
-    if (dec_caplen > offset) {
-        /* allocate buffer for decrypted payload */
-        tmp = (guint8 *)wmem_memdup(pinfo->pool, dec_data+offset, dec_caplen-offset);
-        len = dec_caplen-offset;
+  }
+
+  *algorithm=used_key->KeyType;
+  switch (*algorithm) {
+    case DOT11DECRYPT_KEY_TYPE_WEP:
+      *sec_trailer=DOT11DECRYPT_WEP_TRAILER;
+      break;
+    case DOT11DECRYPT_KEY_TYPE_CCMP:
+      *sec_trailer=DOT11DECRYPT_CCMP_TRAILER;
+      break;
+    case DOT11DECRYPT_KEY_TYPE_CCMP_256:
+      *sec_trailer = DOT11DECRYPT_CCMP_256_TRAILER;
+      break;
+    case DOT11DECRYPT_KEY_TYPE_GCMP:
+    case DOT11DECRYPT_KEY_TYPE_GCMP_256:
+      *sec_trailer = DOT11DECRYPT_GCMP_TRAILER;
+      break;
+    case DOT11DECRYPT_KEY_TYPE_TKIP:
+      *sec_trailer=DOT11DECRYPT_TKIP_TRAILER;
+      break;
+    default:
+      return NULL;
+  }
 
-        /* decrypt successful, let's set up a new data tvb. */
-        decr_tvb = tvb_new_child_real_data(tvb, tmp, len, len);
+  if (payload) {
+    tmp = payload->data;
+    len = payload->data_len;
+  } else {
+    if (dec_caplen <= offset) {
+      return NULL;
+    }
+    len = dec_caplen-offset;
+
+    if (!pinfo->fd->visited &&
+        wlan_decrypt_cache_used + sizeof(proto_decrypted_payload_t) + len <= ((guint64)wlan_decrypt_cache_size << 20)) {
+      /* keep the payload so that redissection does not decrypt it again */
+      const DOT11DECRYPT_KEY_ITEM *key = (const DOT11DECRYPT_KEY_ITEM *)wmem_map_lookup(wlan_decrypt_cache_keys, used_key);
+      if (!key) {
+        key = (const DOT11DECRYPT_KEY_ITEM *)wmem_memdup(wmem_file_scope(), used_key, sizeof(DOT11DECRYPT_KEY_ITEM));
+        wmem_map_insert(wlan_decrypt_cache_keys, key, (void *)key);
+        wlan_decrypt_cache_used += sizeof(DOT11DECRYPT_KEY_ITEM);
+      }
+      payload = wmem_new(wmem_file_scope(), proto_decrypted_payload_t);
+      payload->used_key = key;
+      payload->layer_num = pinfo->curr_layer_num;
+      payload->data_len = len;
+      payload->data = (guint8 *)wmem_memdup(wmem_file_scope(), dec_data+offset, len);
+      p_add_proto_data(wmem_file_scope(), pinfo, proto_wlan, DECRYPTED_PAYLOAD_KEY, payload);
+      wlan_decrypt_cache_used += sizeof(proto_decrypted_payload_t) + len;
+      tmp = payload->data;
+    } else {
+      /* allocate buffer for decrypted payload */
+      tmp = (guint8 *)wmem_memdup(pinfo->pool, dec_data+offset, len);
     }
   }
-  return decr_tvb;
+
+  /* decrypt successful, let's set up a new data tvb. */
+  return tvb_new_child_real_data(tvb, tmp, len, len);
 }
 
 /* Collect our WEP and WPA keys */
@@ -33831,6 +33885,24 @@ weak_iv(guchar *iv)
   return -1;
 }
 
+static void
+wlan_decrypt_cache_init(void)
+{
+  wlan_decrypt_cache_used = 0;
+}
+
+static guint
+wlan_decrypt_cache_key_hash(gconstpointer k)
+{
+  return wmem_strong_hash((const guint8 *)k, sizeof(DOT11DECRYPT_KEY_ITEM));
+}
+
+static gboolean
+wlan_decrypt_cache_key_equal(gconstpointer k1, gconstpointer k2)
+{
+  return memcmp(k1, k2, sizeof(DOT11DECRYPT_KEY_ITEM)) == 0;
+}
+
 static void
 wlan_retransmit_init(void)
 {
@@ -48899,6 +48971,9 @@ proto_register_ieee80211(void)
   sta_prop_hash = wmem_map_new_autoreset(wmem_epan_scope(), wmem_file_scope(),
                                          sta_prop_hash_fn, sta_prop_equal_fn);
 
+  wlan_decrypt_cache_keys = wmem_map_new_autoreset(wmem_epan_scope(), wmem_file_scope(),
+                                                   wlan_decrypt_cache_key_hash, wlan_decrypt_cache_key_equal);
+
   ieee80211_handle = register_dissector("wlan", dissect_ieee80211,                    proto_wlan);
   register_dissector("wlan_withfcs",            dissect_ieee80211_withfcs,            proto_wlan);
   wlan_withoutfcs_handle = register_dissector("wlan_withoutfcs", dissect_ieee80211_withoutfcs, proto_wlan);
@@ -48911,6 +48986,7 @@ proto_register_ieee80211(void)
   reassembly_table_register(&wlan_reassembly_table,
                         &addresses_reassembly_table_functions);
   register_init_routine(wlan_retransmit_init);
+  register_init_routine(wlan_decrypt_cache_init);
   reassembly_table_register(&gas_reassembly_table,
                         &addresses_reassembly_table_functions);
 
@@ -48984,6 +49060,12 @@ proto_register_ieee80211(void)
     "Enable decryption", "Enable WEP and WPA/WPA2 decryption",
     &enable_decryption);
 
+  prefs_register_uint_preference(wlan_module, "decryption_cache_size",
+    "Decrypted payload cache size (MiB)",
+    "Keep up to this much decrypted data so that frames are not decrypted again"
+    " when they are redissected. 0 disables the cache.",
+    10, &wlan_decrypt_cache_size);
+
   wep_uat = uat_new("WEP and WPA Decryption Keys",
             sizeof(uat_wep_key_record_t), /* record size */
             "80211_keys",                 /* filename */
@@ -320,6 +320,9 @@ typedef struct _v9_v10_tmplt {
     guint    length;
     guint16  field_count[TF_NUM];                /* 0:scopes; 1:entries  */
     v9_v10_tmplt_entry_t *fields_p[TF_NUM_EXT];  /* 0:scopes; 1:entries; n:vendor_entries  */
+    /* Summary of the fields, computed when the template is received */
+    gboolean has_var_length;                     /* some field is variable length */
+    gboolean needs_decode;                       /* decoding some field has side effects */
 } v9_v10_tmplt_t;
 
 
@@ -4605,6 +4608,14 @@ dissect_v9_v10_data(tvbuff_t *tvb, packet_info *pinfo, proto_tree *pdutree, int
         }
         proto_item_set_generated(ti);
 
+        if (!pdutree && !tmplt_p->has_var_length && !tmplt_p->needs_decode) {
+            /* Nothing to show and every flow has the same length:
+               just count the flows instead of decoding each field. */
+            count += length / tmplt_p->length;
+            length %= tmplt_p->length;
+            *flows_seen += count - 1;
+        }
+
         /* Note: If the flow contains variable length fields then          */
         /*       tmplt_p->length will be less then actual length of the flow. */
         while (length >= tmplt_p->length) {
@@ -11621,6 +11632,13 @@ dissect_v9_v10_template_fields(tvbuff_t *tvb, packet_info *pinfo _U_, proto_tree
             tmplt_p->fields_p[fields_type][i].pen_str = pen_str;
             if (length != VARIABLE_LENGTH) { /* Don't include "variable length" in the total */
                 tmplt_p->length    += length;
+            } else {
+                tmplt_p->has_var_length = TRUE;
+            }
+            /* Process information (CACE) and nested templates do more than
+               just add items to the tree */
+            if ((pen == VENDOR_CACE) || ((type & 0x7fff) == 292)) {
+                tmplt_p->needs_decode = TRUE;
             }
         }
 
@@ -2224,6 +2224,8 @@ quic_decrypt_message(quic_pp_cipher *pp_cipher, tvbuff_t *head, guint header_len
         *error = "Decryption not possible, ciphertext is too short";
         return;
     }
+    /* Decrypted in place. The plaintext is kept so that later passes can
+     * reuse it, but the ciphertext copy is released if decryption fails. */
     buffer = (guint8 *)tvb_memdup(wmem_file_scope(), head, header_length, buffer_length);
     tvb_memcpy(head, atag, header_length + buffer_length, 16);
 
@@ -2235,6 +2237,7 @@ quic_decrypt_message(quic_pp_cipher *pp_cipher, tvbuff_t *head, guint header_len
     err = gcry_cipher_setiv(pp_cipher->pp_cipher, nonce, TLS13_AEAD_NONCE_LENGTH);
     if (err) {
         *error = wmem_strdup_printf(wmem_file_scope(), "Decryption (setiv) failed: %s", gcry_strerror(err));
+        wmem_free(wmem_file_scope(), buffer);
         return;
     }
 
@@ -2242,6 +2245,7 @@ quic_decrypt_message(quic_pp_cipher *pp_cipher, tvbuff_t *head, guint header_len
     err = gcry_cipher_authenticate(pp_cipher->pp_cipher, header, header_length);
     if (err) {
         *error = wmem_strdup_printf(wmem_file_scope(), "Decryption (authenticate) failed: %s", gcry_strerror(err));
+        wmem_free(wmem_file_scope(), buffer);
         return;
     }
 
@@ -2249,12 +2253,14 @@ quic_decrypt_message(quic_pp_cipher *pp_cipher, tvbuff_t *head, guint header_len
     err = gcry_cipher_decrypt(pp_cipher->pp_cipher, buffer, buffer_length, NULL, 0);
     if (err) {
         *error = wmem_strdup_printf(wmem_file_scope(), "Decryption (decrypt) failed: %s", gcry_strerror(err));
+        wmem_free(wmem_file_scope(), buffer);
         return;
     }
 
     err = gcry_cipher_checktag(pp_cipher->pp_cipher, atag, 16);
     if (err) {
         *error = wmem_strdup_printf(wmem_file_scope(), "Decryption (checktag) failed: %s", gcry_strerror(err));
+        wmem_free(wmem_file_scope(), buffer);
         return;
     }
 
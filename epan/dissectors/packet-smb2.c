@@ -100,6 +100,8 @@ static int hf_smb2_cmd = -1;
 static int hf_smb2_nt_status = -1;
 static int hf_smb2_response_to = -1;
 static int hf_smb2_response_in = -1;
+static int hf_smb2_tracked_requests = -1;
+static int hf_smb2_matched_requests = -1;
 static int hf_smb2_time = -1;
 static int hf_smb2_preauth_hash = -1;
 static int hf_smb2_header_len = -1;
@@ -1314,6 +1316,64 @@ static gboolean seskey_find_sid_key(guint64 sesid, guint8 *out_seskey, guint8 *o
 /* ExportObject preferences variable */
 gboolean eosmb2_take_name_as_fid = FALSE ;
 
+/* Forget requests once their response was seen (single pass only) */
+static gboolean smb2_release_matched = FALSE;
+
+/* With release_matched, requests which never get a response are expired
+ * once they are older than SMB2_UNMATCHED_MAX_AGE seconds. The unmatched
+ * table is only swept when it has doubled in size since the last sweep
+ * (and holds at least SMB2_UNMATCHED_SWEEP_MIN entries), so the cost is
+ * amortized over the requests. */
+#define SMB2_UNMATCHED_MAX_AGE		600
+#define SMB2_UNMATCHED_SWEEP_MIN	1024
+
+static void
+smb2_saved_info_free(smb2_saved_info_t *ssi)
+{
+	wmem_free(wmem_file_scope(), ssi->extra_info);
+	wmem_free(wmem_file_scope(), ssi);
+}
+
+/* Frees a request/response pair which is no longer tracked once the
+ * packet (and its taps) are done with it. */
+static gboolean
+smb2_saved_info_release_cb(wmem_allocator_t *allocator _U_, wmem_cb_event_t event _U_,
+			   void *user_data)
+{
+	smb2_saved_info_free((smb2_saved_info_t *)user_data);
+
+	return FALSE;
+}
+
+static gboolean
+smb2_saved_info_expire(gpointer key _U_, gpointer value, gpointer user_data)
+{
+	smb2_saved_info_t *ssi = (smb2_saved_info_t *)value;
+	const nstime_t *cutoff = (const nstime_t *)user_data;
+
+	if (nstime_cmp(&ssi->req_time, cutoff) >= 0) {
+		return FALSE;
+	}
+	smb2_saved_info_free(ssi);
+	return TRUE;
+}
+
+static void
+smb2_expire_unmatched(smb2_conv_info_t *conv, packet_info *pinfo)
+{
+	nstime_t cutoff;
+	guint size = g_hash_table_size(conv->unmatched);
+
+	if (size < MAX(conv->unmatched_sweep_at, SMB2_UNMATCHED_SWEEP_MIN)) {
+		return;
+	}
+
+	cutoff.secs = pinfo->abs_ts.secs - SMB2_UNMATCHED_MAX_AGE;
+	cutoff.nsecs = pinfo->abs_ts.nsecs;
+	g_hash_table_foreach_remove(conv->unmatched, smb2_saved_info_expire, &cutoff);
+	conv->unmatched_sweep_at = 2 * g_hash_table_size(conv->unmatched);
+}
+
 /* unmatched smb_saved_info structures.
    For unmatched smb_saved_info structures we store the smb_saved_info
    structure using the msg_id field.
@@ -10947,9 +11007,19 @@ dissect_smb2(tvbuff_t *tvb, packet_info *pinfo, proto_tree *parent_tree, gboolea
 					* one
 					*/
 					g_hash_table_remove(si->conv->unmatched, ssi);
+					if (smb2_release_matched) {
+						/* Nothing can match the replaced
+						 * request any more. */
+						wmem_register_callback(wmem_packet_scope(),
+								smb2_saved_info_release_cb, ssi);
+					}
 					ssi = NULL;
 				}
 
+				if (smb2_release_matched) {
+					smb2_expire_unmatched(si->conv, pinfo);
+				}
+
 				if (!ssi) {
 					/* no we couldn't find it, so just add it then
 					* if was a request we are decoding
@@ -10969,9 +11039,29 @@ dissect_smb2(tvbuff_t *tvb, packet_info *pinfo, proto_tree *parent_tree, gboolea
 					/* just  set the response frame and move it to the matched table */
 					ssi->frame_res = pinfo->num;
 					g_hash_table_remove(si->conv->unmatched, ssi);
-					g_hash_table_insert(si->conv->matched, ssi, ssi);
+					if (smb2_release_matched) {
+						/* This frame will not be dissected again, so
+						 * the pair is not needed after this packet. */
+						wmem_register_callback(wmem_packet_scope(),
+								smb2_saved_info_release_cb, ssi);
+					} else {
+						g_hash_table_insert(si->conv->matched, ssi, ssi);
+					}
 				}
 			}
+
+			/* The table sizes are only meaningful while the
+			 * file is read for the first time. */
+			{
+				proto_item *tmp_item;
+
+				tmp_item = proto_tree_add_uint(header_tree, hf_smb2_tracked_requests, tvb, 0, 0,
+						g_hash_table_size(si->conv->unmatched));
+				proto_item_set_generated(tmp_item);
+				tmp_item = proto_tree_add_uint(header_tree, hf_smb2_matched_requests, tvb, 0, 0,
+						g_hash_table_size(si->conv->matched));
+				proto_item_set_generated(tmp_item);
+			}
 		} else {
 			/* see if we can find this msg_id in the matched table */
 			ssi = (smb2_saved_info_t *)g_hash_table_lookup(si->conv->matched, &ssi_key);
@@ -11146,6 +11236,16 @@ proto_register_smb2(void)
 			FRAMENUM_TYPE(FT_FRAMENUM_REQUEST), 0, "This packet is a response to the packet in this frame", HFILL }
 		},
 
+		{ &hf_smb2_tracked_requests,
+			{ "Tracked requests", "smb2.tracked_requests", FT_UINT32, BASE_DEC,
+			NULL, 0, "Number of requests of this connection waiting for a response", HFILL }
+		},
+
+		{ &hf_smb2_matched_requests,
+			{ "Matched requests", "smb2.matched_requests", FT_UINT32, BASE_DEC,
+			NULL, 0, "Number of request/response pairs of this connection kept for later passes", HFILL }
+		},
+
 		{ &hf_smb2_response_in,
 			{ "Response in", "smb2.response_in", FT_FRAMENUM, BASE_NONE,
 			FRAMENUM_TYPE(FT_FRAMENUM_RESPONSE), 0, "The response to this packet is in this packet", HFILL }
@@ -13870,6 +13970,15 @@ proto_register_smb2(void)
 		"Whether the dissector should try to verify SMB2 signatures",
 		&smb2_verify_signatures);
 
+	prefs_register_bool_preference(smb2_module, "release_matched",
+		"Release matched requests (single pass only)",
+		"Free the state of requests once their response was seen, so that"
+		" memory stays bounded on long captures. Response times are still"
+		" computed, but frames cannot be dissected again correctly, so only"
+		" use this with TShark without -2. Requests which did not get a"
+		" response within 10 minutes are forgotten as well.",
+		&smb2_release_matched);
+
 	seskey_uat = uat_new("Secret session key to use for decryption",
 			     sizeof(smb2_seskey_field_t),
 			     "smb2_seskey_list",
@@ -111,6 +111,8 @@ typedef struct _smb2_conv_info_t {
 	/* these two tables are used to match requests with responses */
 	GHashTable *unmatched;
 	GHashTable *matched;
+	/* unmatched size at which stale requests are expired next */
+	guint unmatched_sweep_at;
 	guint16 dialect;
 	guint16 enc_alg;
 
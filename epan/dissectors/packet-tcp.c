@@ -29,6 +29,7 @@
 #include <epan/exported_pdu.h>
 #include <epan/in_cksum.h>
 #include <epan/proto_data.h>
+#include <epan/unit_strings.h>
 
 #include <wsutil/utf8_entities.h>
 #include <wsutil/str_util.h>
@@ -142,6 +143,7 @@ static int hf_tcp_dstport = -1;
 static int hf_tcp_port = -1;
 static int hf_tcp_stream = -1;
 static int hf_tcp_completeness = -1;
+static int hf_tcp_analysis_state_bytes = -1;
 static int hf_tcp_seq = -1;
 static int hf_tcp_seq_abs = -1;
 static int hf_tcp_nxtseq = -1;
@@ -1430,6 +1432,37 @@ static gboolean tcp_analyze_seq           = TRUE;
 static gboolean tcp_relative_seq          = TRUE;
 static gboolean tcp_track_bytes_in_flight = TRUE;
 static gboolean tcp_calculate_ts          = TRUE;
+static gboolean tcp_analyze_streaming     = FALSE;
+static guint    tcp_streaming_idle_timeout = 300; /* seconds */
+
+/* How long a reset or closed conversation keeps its analysis state in
+ * streaming mode, so that retransmissions and final ACKs are still
+ * analyzed.
+ */
+#define TCP_STREAMING_CLOSE_LINGER 10 /* seconds */
+
+/* Conversations holding analysis state in streaming mode, least recently
+ * active first. Closed conversations are kept on their own list since they
+ * time out sooner.
+ */
+typedef struct {
+    struct tcp_analysis *head;
+    struct tcp_analysis *tail;
+} tcp_active_list_t;
+
+static tcp_active_list_t tcp_open_conversations;
+static tcp_active_list_t tcp_closed_conversations;
+
+/* Desegmentation of TCP streams */
+static reassembly_table tcp_reassembly_table;
+
+/* Most gaps tracked per MSP before falling back to scanning its fragments. */
+#define TCP_OOO_MAX_RANGES 64
+
+struct tcp_ooo_range {
+    guint32 start;
+    guint32 end;
+};
 
 static gboolean tcp_analyze_mptcp                   = TRUE;
 static gboolean mptcp_relative_seq                  = TRUE;
@@ -1615,6 +1648,7 @@ get_tcp_conversation_data(conversation_t *conv, packet_info *pinfo)
      */
     if (!tcpd) {
         tcpd = init_tcp_conversation_data(pinfo);
+        tcpd->conversation = conv;
         conversation_add_proto_data(conv, proto_tcp, tcpd);
     }
 
@@ -1851,6 +1885,9 @@ pdu_store_sequencenumber_of_next_pdu(packet_info *pinfo, guint32 seq, guint32 nx
     msp->last_frame=pinfo->num;
     msp->last_frame_time=pinfo->abs_ts;
     msp->flags=0;
+    msp->contiguous_len=0;
+    msp->ooo_range_count=0;
+    msp->ooo_ranges=NULL;
     wmem_tree_insert32(multisegment_pdus, seq, (void *)msp);
     /*g_warning("pdu_store_sequencenumber_of_next_pdu: seq %u", seq);*/
     return msp;
@@ -1938,9 +1975,254 @@ tcp_analyze_get_acked_struct(guint32 frame, guint32 seq, guint32 ack, gboolean c
 
     tcpd->ta = (struct tcp_acked *)wmem_tree_lookup32_array(tcpd->acked_table, key);
     if((!tcpd->ta) && createflag) {
-        tcpd->ta = wmem_new0(wmem_file_scope(), struct tcp_acked);
-        wmem_tree_insert32_array(tcpd->acked_table, key, (void *)tcpd->ta);
+        if (tcp_analyze_streaming) {
+            /* Frames aren't dissected again, so this is only needed
+             * while the current one is being dissected. */
+            tcpd->ta = wmem_new0(wmem_packet_scope(), struct tcp_acked);
+        } else {
+            tcpd->ta = wmem_new0(wmem_file_scope(), struct tcp_acked);
+            wmem_tree_insert32_array(tcpd->acked_table, key, (void *)tcpd->ta);
+        }
+    }
+}
+
+static void
+tcp_active_list_remove(struct tcp_analysis *tcpd)
+{
+    tcp_active_list_t *list;
+
+    if (tcpd->active_list == 0) {
+        return;
+    }
+    list = tcpd->active_list == 1 ? &tcp_open_conversations : &tcp_closed_conversations;
+
+    if (tcpd->active_prev) {
+        tcpd->active_prev->active_next = tcpd->active_next;
+    } else {
+        list->head = tcpd->active_next;
+    }
+    if (tcpd->active_next) {
+        tcpd->active_next->active_prev = tcpd->active_prev;
+    } else {
+        list->tail = tcpd->active_prev;
+    }
+    tcpd->active_prev = tcpd->active_next = NULL;
+    tcpd->active_list = 0;
+}
+
+static void
+tcp_active_list_append(struct tcp_analysis *tcpd, guint8 which)
+{
+    tcp_active_list_t *list = which == 1 ? &tcp_open_conversations : &tcp_closed_conversations;
+
+    tcpd->active_prev = list->tail;
+    tcpd->active_next = NULL;
+    if (list->tail) {
+        list->tail->active_next = tcpd;
+    } else {
+        list->head = tcpd;
+    }
+    list->tail = tcpd;
+    tcpd->active_list = which;
+}
+
+/* Set the endpoints of a flow of the conversation in flow_pinfo, so that it
+ * can be used to look up the reassembly fragments of the flow. */
+static void
+tcp_flow_endpoints(struct tcp_analysis *tcpd, tcp_flow_t *flow, packet_info *flow_pinfo)
+{
+    conversation_key_t key = tcpd->conversation->key_ptr;
+    address *addr1 = conversation_key_addr1(key);
+    address *addr2 = conversation_key_addr2(key);
+    guint32 port1 = conversation_key_port1(key);
+    guint32 port2 = conversation_key_port2(key);
+    int direction;
+
+    /* flow1 holds the segments sent by the greater endpoint, as in
+     * get_tcp_conversation_data(). */
+    direction = cmp_address(addr1, addr2);
+    if (direction == 0) {
+        direction = (port1 > port2) ? 1 : -1;
+    }
+    if ((direction >= 0) != (flow == &tcpd->flow1)) {
+        address *addr = addr1;
+        guint32 port = port1;
+
+        addr1 = addr2;
+        addr2 = addr;
+        port1 = port2;
+        port2 = port;
+    }
+    memset(flow_pinfo, 0, sizeof(*flow_pinfo));
+    copy_address_shallow(&flow_pinfo->src, addr1);
+    copy_address_shallow(&flow_pinfo->dst, addr2);
+    flow_pinfo->srcport = port1;
+    flow_pinfo->destport = port2;
+}
+
+/* Drop the fragments of a multi-segment PDU that is still being reassembled. */
+static gboolean
+tcp_msp_fragment_delete(const void *key _U_, void *value, void *userdata)
+{
+    struct tcp_multisegment_pdu *msp = (struct tcp_multisegment_pdu *)value;
+    tvbuff_t *tvb_data;
+
+    tvb_data = fragment_delete(&tcp_reassembly_table, (const packet_info *)userdata, msp->first_frame, NULL);
+    if (tvb_data) {
+        tvb_free(tvb_data);
+    }
+    return FALSE;
+}
+
+/* Free the unACKed segments and multi-segment PDUs of a flow. pinfo only
+ * holds the endpoints of the flow, which key its reassembly fragments.
+ */
+static void
+tcp_release_flow_state(tcp_flow_t *flow, const packet_info *pinfo)
+{
+    if (flow->tcp_analyze_seq_info) {
+        tcp_unacked_t *ual = flow->tcp_analyze_seq_info->segments;
+
+        while (ual) {
+            tcp_unacked_t *next = ual->next;
+            wmem_free(wmem_file_scope(), ual);
+            ual = next;
+        }
+        flow->tcp_analyze_seq_info->segments = NULL;
+        flow->tcp_analyze_seq_info->segment_count = 0;
+    }
+
+    if (!wmem_tree_is_empty(flow->multisegment_pdus)) {
+        wmem_tree_foreach(flow->multisegment_pdus, tcp_msp_fragment_delete, (void *)pinfo);
+        wmem_tree_destroy(flow->multisegment_pdus, FALSE, TRUE);
+        flow->multisegment_pdus = wmem_tree_new(wmem_file_scope());
+    }
+}
+
+static void
+tcp_release_analysis_state(struct tcp_analysis *tcpd)
+{
+    packet_info flow_pinfo;
+
+    tcp_active_list_remove(tcpd);
+    tcp_flow_endpoints(tcpd, &tcpd->flow1, &flow_pinfo);
+    tcp_release_flow_state(&tcpd->flow1, &flow_pinfo);
+    tcp_flow_endpoints(tcpd, &tcpd->flow2, &flow_pinfo);
+    tcp_release_flow_state(&tcpd->flow2, &flow_pinfo);
+    if (!wmem_tree_is_empty(tcpd->acked_table)) {
+        wmem_tree_destroy(tcpd->acked_table, FALSE, TRUE);
+        tcpd->acked_table = wmem_tree_new(wmem_file_scope());
+    }
+}
+
+typedef struct {
+    const packet_info *flow_pinfo;
+    guint32 bytes;
+} tcp_msp_bytes_t;
+
+/* Add the size of a multi-segment PDU and of the data collected so far for
+ * its reassembly. */
+static gboolean
+tcp_msp_add_bytes(const void *key _U_, void *value, void *userdata)
+{
+    struct tcp_multisegment_pdu *msp = (struct tcp_multisegment_pdu *)value;
+    tcp_msp_bytes_t *msp_bytes = (tcp_msp_bytes_t *)userdata;
+    fragment_head *fd_head;
+    fragment_item *fd;
+
+    msp_bytes->bytes += (guint32) sizeof(struct tcp_multisegment_pdu);
+    if (msp->ooo_ranges) {
+        msp_bytes->bytes += TCP_OOO_MAX_RANGES * (guint32) sizeof(struct tcp_ooo_range);
+    }
+    fd_head = fragment_get(&tcp_reassembly_table, msp_bytes->flow_pinfo, msp->first_frame, NULL);
+    if (fd_head) {
+        for (fd = fd_head->next; fd; fd = fd->next) {
+            msp_bytes->bytes += (guint32) sizeof(fragment_item) + fd->len;
+        }
+    }
+    return FALSE;
+}
+
+/* Approximate size of the analysis state held for a conversation: the
+ * unACKed segments, and the multi-segment PDUs with their pending
+ * reassembly data. */
+static guint32
+tcp_analysis_state_bytes(struct tcp_analysis *tcpd)
+{
+    guint32 bytes = (guint32) sizeof(struct tcp_analysis);
+    tcp_flow_t *flows[2] = { &tcpd->flow1, &tcpd->flow2 };
+    packet_info flow_pinfo;
+    tcp_msp_bytes_t msp_bytes;
+
+    for (int i = 0; i < 2; i++) {
+        if (flows[i]->tcp_analyze_seq_info) {
+            bytes += (guint32) sizeof(tcp_analyze_seq_flow_info_t);
+            bytes += flows[i]->tcp_analyze_seq_info->segment_count * (guint32) sizeof(tcp_unacked_t);
+        }
+        if (!wmem_tree_is_empty(flows[i]->multisegment_pdus)) {
+            tcp_flow_endpoints(tcpd, flows[i], &flow_pinfo);
+            msp_bytes.flow_pinfo = &flow_pinfo;
+            msp_bytes.bytes = 0;
+            wmem_tree_foreach(flows[i]->multisegment_pdus, tcp_msp_add_bytes, &msp_bytes);
+            bytes += msp_bytes.bytes;
+        }
+    }
+    return bytes;
+}
+
+/* Streaming mode: mark this conversation as active and release the
+ * state of conversations that have been idle for too long, or that were
+ * closed and have since lingered for TCP_STREAMING_CLOSE_LINGER seconds.
+ * Called on the first (and only) pass.
+ */
+static void
+tcp_streaming_update(packet_info *pinfo, struct tcp_analysis *tcpd, guint16 flags)
+{
+    time_t now = pinfo->abs_ts.secs;
+    guint8 which = tcpd->active_list == 2 ? 2 : 1;
+
+    if (flags & (TH_FIN|TH_RST)) {
+        which = 2;
+    }
+    tcp_active_list_remove(tcpd);
+    tcpd->last_active = now;
+    tcp_active_list_append(tcpd, which);
+
+    while (tcp_open_conversations.head != tcpd && tcp_open_conversations.head
+           && now - tcp_open_conversations.head->last_active > (time_t) tcp_streaming_idle_timeout) {
+        tcp_release_analysis_state(tcp_open_conversations.head);
     }
+    while (tcp_closed_conversations.head != tcpd && tcp_closed_conversations.head
+           && now - tcp_closed_conversations.head->last_active > TCP_STREAMING_CLOSE_LINGER) {
+        tcp_release_analysis_state(tcp_closed_conversations.head);
+    }
+}
+
+static void
+tcp_free_flow(tcp_flow_t *flow)
+{
+    wmem_tree_destroy(flow->multisegment_pdus, FALSE, TRUE);
+    wmem_free(wmem_file_scope(), flow->tcp_analyze_seq_info);
+    wmem_free(wmem_file_scope(), flow->process_info);
+}
+
+/* The conversation is being evicted; it will not be seen again. MPTCP
+ * subflows are still referenced from their meta connection, so only their
+ * analysis state is released.
+ */
+static void
+tcp_conversation_evicted(conversation_t *conv _U_, void *proto_data)
+{
+    struct tcp_analysis *tcpd = (struct tcp_analysis *)proto_data;
+
+    tcp_release_analysis_state(tcpd);
+    if (tcpd->mptcp_analysis) {
+        return;
+    }
+    tcp_free_flow(&tcpd->flow1);
+    tcp_free_flow(&tcpd->flow2);
+    wmem_tree_destroy(tcpd->acked_table, FALSE, TRUE);
+    wmem_free(wmem_file_scope(), tcpd);
 }
 
 
@@ -3185,9 +3467,6 @@ print_tcp_fragment_tree(fragment_head *ipfd_head, proto_tree *tree, proto_tree *
 /* Minimum TCP header length. */
 #define TCPH_MIN_LEN            20
 
-/* Desegmentation of TCP streams */
-static reassembly_table tcp_reassembly_table;
-
 /* functions to trace tcp segments */
 /* Enable desegmenting of TCP streams */
 static gboolean tcp_desegment = TRUE;
@@ -3196,6 +3475,79 @@ static gboolean tcp_desegment = TRUE;
  * subdissector (depends on "tcp_desegment"). */
 static gboolean tcp_reassemble_out_of_order = FALSE;
 
+/* Record that the bytes [start, end) relative to msp->seq were added to the
+ * MSP. Data up to the first gap only moves contiguous_len; anything after it
+ * is kept as sorted, disjoint ranges which are merged as the gaps fill in.
+ */
+static void
+msp_add_range(struct tcp_multisegment_pdu *msp, guint32 start, guint32 end)
+{
+    struct tcp_ooo_range *ranges = msp->ooo_ranges;
+    guint32 count = msp->ooo_range_count;
+    guint32 lo, hi, i;
+
+    if (end <= start || (msp->flags & MSP_FLAGS_OOO_UNINDEXED)) {
+        return;
+    }
+
+    if (start <= msp->contiguous_len) {
+        if (end > msp->contiguous_len) {
+            msp->contiguous_len = end;
+        }
+        /* Absorb the ranges which are now adjacent. */
+        for (i = 0; i < count && ranges[i].start <= msp->contiguous_len; i++) {
+            if (ranges[i].end > msp->contiguous_len) {
+                msp->contiguous_len = ranges[i].end;
+            }
+        }
+        if (i > 0) {
+            memmove(ranges, ranges + i, (count - i) * sizeof(*ranges));
+            msp->ooo_range_count = count - i;
+        }
+        return;
+    }
+
+    /* First range which ends at or after start... */
+    lo = 0;
+    hi = count;
+    while (lo < hi) {
+        guint32 mid = lo + (hi - lo) / 2;
+        if (ranges[mid].end < start) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    /* ...and the first one after lo which starts after end. */
+    for (hi = lo; hi < count && ranges[hi].start <= end; hi++)
+        ;
+
+    if (lo < hi) {
+        /* Overlaps or touches ranges lo..hi-1, merge them into lo. */
+        ranges[lo].start = MIN(ranges[lo].start, start);
+        ranges[lo].end = MAX(ranges[hi - 1].end, end);
+        memmove(ranges + lo + 1, ranges + hi, (count - hi) * sizeof(*ranges));
+        msp->ooo_range_count = count - (hi - lo - 1);
+        return;
+    }
+
+    if (count == TCP_OOO_MAX_RANGES) {
+        /* Give up on the index rather than grow it without bound. */
+        wmem_free(wmem_file_scope(), ranges);
+        msp->ooo_ranges = NULL;
+        msp->ooo_range_count = 0;
+        msp->flags |= MSP_FLAGS_OOO_UNINDEXED;
+        return;
+    }
+    if (!ranges) {
+        ranges = msp->ooo_ranges = wmem_alloc_array(wmem_file_scope(), struct tcp_ooo_range, TCP_OOO_MAX_RANGES);
+    }
+    memmove(ranges + lo + 1, ranges + lo, (count - lo) * sizeof(*ranges));
+    ranges[lo].start = start;
+    ranges[lo].end = end;
+    msp->ooo_range_count = count + 1;
+}
+
 /* Returns true iff any gap exists in the segments associated with msp up to the
  * given sequence number (it ignores any gaps after the sequence number). */
 static gboolean
@@ -3208,6 +3560,10 @@ missing_segments(packet_info *pinfo, struct tcp_multisegment_pdu *msp, guint32 s
         return FALSE;
     }
 
+    if (!(msp->flags & MSP_FLAGS_OOO_UNINDEXED)) {
+        return msp->contiguous_len < frag_offset;
+    }
+
     fd_head = fragment_get(&tcp_reassembly_table, pinfo, msp->first_frame, NULL);
     /* msp implies existence of fragments, this should never be NULL. */
     DISSECTOR_ASSERT(fd_head);
@@ -3500,6 +3856,8 @@ again:
         }
 
         if (reassemble_ooo && !PINFO_FD_VISITED(pinfo)) {
+            msp_add_range(msp, seq - msp->seq, seq - msp->seq + len);
+
             /* If the first segment of the MSP was seen, remember it. */
             if (msp->seq == seq && msp->flags & MSP_FLAGS_MISSING_FIRST_SEGMENT) {
                 msp->first_frame_with_seq = pinfo->num;
@@ -3810,6 +4168,7 @@ again:
                          pinfo, msp->first_frame, NULL,
                          0, nxtseq - deseg_seq,
                          LT_SEQ(nxtseq, msp->nxtpdu));
+            msp_add_range(msp, 0, nxtseq - deseg_seq);
         }
     }
 
@@ -6541,6 +6900,12 @@ dissect_tcp(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, void* data _U_)
         item = proto_tree_add_uint(tcp_tree, hf_tcp_completeness, NULL, 0, 0, tcpd->conversation_completeness);
         proto_item_set_generated(item);
 
+        /* Walks the multi-segment PDUs, only do it for a tree. */
+        if (tcp_analyze_streaming && tcp_tree) {
+            item = proto_tree_add_uint(tcp_tree, hf_tcp_analysis_state_bytes, tvb, 0, 0, tcp_analysis_state_bytes(tcpd));
+            proto_item_set_generated(item);
+        }
+
         /* Copy the stream index into the header as well to make it available
          * to tap listeners.
          */
@@ -6560,8 +6925,12 @@ dissect_tcp(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, void* data _U_)
          * Calculate the timestamps relative to this conversation (but only on the
          * first run when frames are accessed sequentially)
          */
-        if (!(pinfo->fd->visited))
+        if (!(pinfo->fd->visited)) {
+            /* In streaming mode the delta is only needed on this pass. */
+            if (!tcppd && tcp_analyze_streaming)
+                tcppd = wmem_new(pinfo->pool, struct tcp_per_packet_data_t);
             tcp_calculate_timestamps(pinfo, tcpd, tcppd);
+        }
     }
 
     /*
@@ -6713,6 +7082,10 @@ dissect_tcp(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, void* data _U_)
     }
     tcpd->conversation_completeness = conversation_completeness;
 
+    if (tcp_analyze_streaming && tcpd && !PINFO_FD_VISITED(pinfo)) {
+        tcp_streaming_update(pinfo, tcpd, tcph->th_flags);
+    }
+
     if (tcp_summary_in_tree) {
         if(tcph->th_flags&TH_ACK) {
             proto_item_append_text(ti, ", Ack: %u", tcph->th_ack);
@@ -7269,6 +7642,8 @@ static void
 tcp_init(void)
 {
     tcp_stream_count = 0;
+    tcp_open_conversations.head = tcp_open_conversations.tail = NULL;
+    tcp_closed_conversations.head = tcp_closed_conversations.tail = NULL;
 
     /* MPTCP init */
     mptcp_stream_count = 0;
@@ -7301,6 +7676,11 @@ proto_register_tcp(void)
             BASE_CUSTOM, CF_FUNC(conversation_completeness_fill), 0x0,
             "The completeness of the conversation capture", HFILL }},
 
+        { &hf_tcp_analysis_state_bytes,
+        { "Analysis state",       "tcp.analysis.state_bytes", FT_UINT32,
+            BASE_DEC|BASE_UNIT_STRING, &units_byte_bytes, 0x0,
+            "Approximate memory held for sequence analysis and reassembly of this conversation", HFILL }},
+
         { &hf_tcp_seq,
         { "Sequence Number",        "tcp.seq", FT_UINT32, BASE_DEC, NULL, 0x0,
             NULL, HFILL }},
@@ -8232,6 +8612,7 @@ proto_register_tcp(void)
     /* subdissector code */
     subdissector_table = register_dissector_table("tcp.port",
         "TCP port", proto_tcp, FT_UINT16, BASE_DEC);
+    dissector_table_use_flat_lookup(subdissector_table);
     heur_subdissector_list = register_heur_dissector_list("tcp", proto_tcp);
     tcp_option_table = register_dissector_table("tcp.option",
         "TCP Options", proto_tcp, FT_UINT8, BASE_DEC);
@@ -8313,6 +8694,17 @@ proto_register_tcp(void)
         "Calculate conversation timestamps",
         "Calculate timestamps relative to the first frame and the previous frame in the tcp conversation",
         &tcp_calculate_ts);
+    prefs_register_bool_preference(tcp_module, "streaming_analysis",
+        "Release analysis state of finished conversations",
+        "Don't keep sequence analysis results after a packet has been dissected, and release the "
+        "unACKed segment and multi-segment PDU state of conversations that have been closed, reset or "
+        "idle for a while. This keeps memory flat in long single-pass captures such as \"tshark -i\", "
+        "but analysis results won't be shown if packets are dissected again, as in Wireshark or \"tshark -2\".",
+        &tcp_analyze_streaming);
+    prefs_register_uint_preference(tcp_module, "streaming_idle_timeout",
+        "Idle timeout for released analysis state (seconds)",
+        "When releasing analysis state, how long a conversation can be idle before its state is released",
+        10, &tcp_streaming_idle_timeout);
     prefs_register_bool_preference(tcp_module, "try_heuristic_first",
         "Try heuristic sub-dissectors first",
         "Try to decode a packet using an heuristic sub-dissector before using a sub-dissector registered to a specific port",
@@ -8342,6 +8734,7 @@ proto_register_tcp(void)
         &tcp_display_process_info);
 
     register_init_routine(tcp_init);
+    conversation_register_evict_callback(proto_tcp, tcp_conversation_evicted);
     reassembly_table_register(&tcp_reassembly_table,
                           &addresses_ports_reassembly_table_functions);
 
@@ -185,6 +185,13 @@ struct tcp_multisegment_pdu {
 #define MSP_FLAGS_GOT_ALL_SEGMENTS		0x00000002
 /* Whether the first segment of this MSP was not yet seen. */
 #define MSP_FLAGS_MISSING_FIRST_SEGMENT		0x00000004
+/* Whether the received ranges are no longer indexed (too many gaps). */
+#define MSP_FLAGS_OOO_UNINDEXED			0x00000008
+	/* Received data, as offsets from 'seq'. Only maintained when
+	 * out-of-order reassembly is enabled. */
+	guint32 contiguous_len;		/* Bytes received without a gap. */
+	guint32 ooo_range_count;
+	struct tcp_ooo_range *ooo_ranges; /* Sorted, disjoint ranges after the first gap. */
 };
 
 
@@ -480,6 +487,21 @@ struct tcp_analysis {
 	 * connection or left before it was terminated explicitly
 	 */
 	guint8          conversation_completeness;
+
+	/* Links in the list of conversations holding analysis state, least
+	 * recently active first. Only used with the "streaming_analysis"
+	 * preference, which releases that state once a conversation has been
+	 * closed or idle for a while.
+	 */
+	struct tcp_analysis *active_prev;
+	struct tcp_analysis *active_next;
+	time_t          last_active;
+	guint8          active_list;	/* 0: none, 1: open, 2: closed */
+
+	/* The conversation this analysis belongs to, whose endpoints key the
+	 * reassembly of its multi-segment PDUs.
+	 */
+	conversation_t *conversation;
 };
 
 /* Structure that keeps per packet data. First used to be able
@@ -5381,11 +5381,17 @@ ssl_add_record_info(gint proto, packet_info *pinfo, const guchar *data, gint dat
     SslRecordInfo* rec, **prec;
     SslPacketInfo *pi = tls_add_packet_info(proto, pinfo, curr_layer_num_ssl);
 
-    rec = wmem_new(wmem_file_scope(), SslRecordInfo);
-    rec->plain_data = (guchar *)wmem_memdup(wmem_file_scope(), data, data_len);
+    /* The plaintext is kept for the lifetime of the file so that later
+     * passes need not decrypt again; store it right after the record to
+     * avoid a second allocation per record. */
+    rec = (SslRecordInfo *)wmem_alloc(wmem_file_scope(), sizeof(SslRecordInfo) + data_len);
+    rec->plain_data = (guchar *)(rec + 1);
+    memcpy(rec->plain_data, data, data_len);
     rec->data_len = data_len;
     rec->id = record_id;
     rec->type = type;
+    rec->flow = NULL;
+    rec->seq = 0;
     rec->next = NULL;
 
     if (flow && type == SSL_ID_APP_DATA) {
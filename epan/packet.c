@@ -26,6 +26,7 @@
 #include "to_str.h"
 
 #include "addr_resolv.h"
+#include "conversation.h"
 #include "tvbuff.h"
 #include "epan_dissect.h"
 
@@ -79,6 +80,14 @@ struct data_source {
  *
  * "protocol" is the protocol associated with the dissector table. Used
  * for determining dependencies.
+ *
+ * "flat_entries", if not NULL, is an array of "flat_len" dtbl_entry_t
+ * pointers indexed directly by uint value, mirroring "hash_table" for
+ * the values below "flat_len"; it is used for lookups in tables with
+ * a small, densely used key space (FT_UINT8 tables, and FT_UINT16
+ * tables marked with dissector_table_use_flat_lookup()).  It is rebuilt
+ * from "hash_table" on the first lookup after "flat_dirty" is set,
+ * which every change to "hash_table" does.
  */
 struct dissector_table {
 	GHashTable	*hash_table;
@@ -89,6 +98,9 @@ struct dissector_table {
 	protocol_t	*protocol;
 	GHashFunc	hash_func;
 	gboolean	supports_decode_as;
+	dtbl_entry_t	**flat_entries;
+	guint32		flat_len;
+	gboolean	flat_dirty;
 };
 
 /*
@@ -157,6 +169,7 @@ destroy_depend_dissector_list(void *data)
 struct heur_dissector_list {
 	protocol_t	*protocol;
 	GSList		*dissectors;
+	wmem_map_t	*conv_cache;	/* conversation_t * -> heur_dtbl_entry_t * that last accepted */
 };
 
 static GHashTable *heur_dissector_lists = NULL;
@@ -190,6 +203,7 @@ destroy_dissector_table(void *data)
 
 	g_hash_table_destroy(table->hash_table);
 	g_slist_free(table->dissector_handles);
+	g_free(table->flat_entries);
 	g_slice_free(struct dissector_table, data);
 }
 
@@ -309,6 +323,22 @@ register_shutdown_routine(void (*func)(void))
 }
 
 /* Initialize all data structures used for dissection. */
+/* Start the counters of the heuristic dissectors over for a new file. */
+static void
+heur_reset_counters(gpointer key _U_, gpointer value, gpointer user_data _U_)
+{
+	struct heur_dissector_list *sub_dissectors = (struct heur_dissector_list *)value;
+	GSList *entry;
+
+	for (entry = sub_dissectors->dissectors; entry != NULL; entry = g_slist_next(entry)) {
+		heur_dtbl_entry_t *hdtbl_entry = (heur_dtbl_entry_t *)entry->data;
+
+		hdtbl_entry->calls     = 0;
+		hdtbl_entry->accepts   = 0;
+		hdtbl_entry->conv_hits = 0;
+	}
+}
+
 void
 init_dissection(void)
 {
@@ -327,6 +357,8 @@ init_dissection(void)
 	/* Initialize protocol-specific variables. */
 	g_slist_foreach(init_routines, &call_routine, NULL);
 
+	g_hash_table_foreach(heur_dissector_lists, heur_reset_counters, NULL);
+
 	/* Initialize the stream-handling tables */
 	stream_init();
 
@@ -583,6 +615,10 @@ dissect_record(epan_dissect_t *edt, int file_type_subtype,
 	frame_dissector_data.file_type_subtype = file_type_subtype;
 	frame_dissector_data.color_edt = edt; /* Used strictly for "coloring rules" */
 
+	/* Free idle conversations before this frame can look any up. */
+	if (!fd->visited)
+		conversation_evict_idle(&edt->pi);
+
 	TRY {
 		/* Add this tvbuffer into the data_src list */
 		add_new_data_source(&edt->pi, edt->tvb, record_type);
@@ -969,6 +1005,32 @@ find_dissector_table(const char *name)
 	return dissector_table;
 }
 
+/* Copy one hash table entry into the flat lookup array. */
+static void
+dissector_table_fill_flat(gpointer key, gpointer value, gpointer user_data)
+{
+	dissector_table_t sub_dissectors = (dissector_table_t)user_data;
+	guint32           pattern = GPOINTER_TO_UINT(key);
+
+	if (pattern < sub_dissectors->flat_len)
+		sub_dissectors->flat_entries[pattern] = (dtbl_entry_t *)value;
+}
+
+/*
+ * Rebuild the flat lookup array of a uint dissector table from its
+ * hash table.  This is only done lazily, on the first lookup after the
+ * table was changed, so a burst of registrations or a "Decode As"
+ * change costs one rebuild.
+ */
+static void
+dissector_table_rebuild_flat(dissector_table_t sub_dissectors)
+{
+	memset(sub_dissectors->flat_entries, 0,
+	    sub_dissectors->flat_len * sizeof(dtbl_entry_t *));
+	g_hash_table_foreach(sub_dissectors->hash_table, dissector_table_fill_flat, sub_dissectors);
+	sub_dissectors->flat_dirty = FALSE;
+}
+
 /* Find an entry in a uint dissector table. */
 static dtbl_entry_t *
 find_uint_dtbl_entry(dissector_table_t sub_dissectors, const guint32 pattern)
@@ -996,8 +1058,15 @@ find_uint_dtbl_entry(dissector_table_t sub_dissectors, const guint32 pattern)
 	}
 
 	/*
-	 * Find the entry.
+	 * Find the entry; use the flat array if we have one and the value
+	 * is covered by it.
 	 */
+	if (sub_dissectors->flat_entries != NULL && pattern < sub_dissectors->flat_len) {
+		if (G_UNLIKELY(sub_dissectors->flat_dirty))
+			dissector_table_rebuild_flat(sub_dissectors);
+		return sub_dissectors->flat_entries[pattern];
+	}
+
 	return (dtbl_entry_t *)g_hash_table_lookup(sub_dissectors->hash_table,
 				   GUINT_TO_POINTER(pattern));
 }
@@ -1081,6 +1150,7 @@ dissector_add_uint(const char *name, const guint32 pattern, dissector_handle_t h
 	/* do the table insertion */
 	g_hash_table_insert(sub_dissectors->hash_table,
 			     GUINT_TO_POINTER(pattern), (gpointer)dtbl_entry);
+	sub_dissectors->flat_dirty = TRUE;
 
 	/*
 	 * Now, if this table supports "Decode As", add this handle
@@ -1242,6 +1312,7 @@ dissector_delete_uint(const char *name, const guint32 pattern,
 		 */
 		g_hash_table_remove(sub_dissectors->hash_table,
 				    GUINT_TO_POINTER(pattern));
+		sub_dissectors->flat_dirty = TRUE;
 	}
 }
 
@@ -1283,6 +1354,7 @@ void dissector_delete_all(const char *name, dissector_handle_t handle)
 	g_assert (sub_dissectors);
 
 	g_hash_table_foreach_remove (sub_dissectors->hash_table, dissector_delete_all_check, handle);
+	sub_dissectors->flat_dirty = TRUE;
 }
 
 static void
@@ -1292,6 +1364,7 @@ dissector_delete_from_table(gpointer key _U_, gpointer value, gpointer user_data
 	g_assert (sub_dissectors);
 
 	g_hash_table_foreach_remove(sub_dissectors->hash_table, dissector_delete_all_check, user_data);
+	sub_dissectors->flat_dirty = TRUE;
 	sub_dissectors->dissector_handles = g_slist_remove(sub_dissectors->dissector_handles, user_data);
 }
 
@@ -1337,6 +1410,7 @@ dissector_change_uint(const char *name, const guint32 pattern, dissector_handle_
 	/* do the table insertion */
 	g_hash_table_insert(sub_dissectors->hash_table,
 			     GUINT_TO_POINTER(pattern), (gpointer)dtbl_entry);
+	sub_dissectors->flat_dirty = TRUE;
 }
 
 /* Reset an entry in a uint dissector table to its initial value. */
@@ -1365,6 +1439,7 @@ dissector_reset_uint(const char *name, const guint32 pattern)
 	} else {
 		g_hash_table_remove(sub_dissectors->hash_table,
 				    GUINT_TO_POINTER(pattern));
+		sub_dissectors->flat_dirty = TRUE;
 	}
 }
 
@@ -2180,6 +2255,19 @@ dissector_table_allow_decode_as(dissector_table_t dissector_table)
 	dissector_table->supports_decode_as = TRUE;
 }
 
+void
+dissector_table_use_flat_lookup(dissector_table_t dissector_table)
+{
+	g_assert(dissector_table->type == FT_UINT8 || dissector_table->type == FT_UINT16);
+
+	if (dissector_table->flat_entries != NULL)
+		return;
+
+	dissector_table->flat_len = (dissector_table->type == FT_UINT8) ? G_MAXUINT8 + 1 : G_MAXUINT16 + 1;
+	dissector_table->flat_entries = g_new0(dtbl_entry_t *, dissector_table->flat_len);
+	dissector_table->flat_dirty = TRUE;
+}
+
 static gint
 uuid_equal(gconstpointer k1, gconstpointer k2)
 {
@@ -2505,6 +2593,15 @@ register_dissector_table(const char *name, const char *ui_name, const int proto,
 	sub_dissectors->param   = param;
 	sub_dissectors->protocol  = find_protocol_by_id(proto);
 	sub_dissectors->supports_decode_as = FALSE;
+	/* 8-bit tables are cheap enough to always index directly */
+	if (type == FT_UINT8) {
+		sub_dissectors->flat_len = G_MAXUINT8 + 1;
+		sub_dissectors->flat_entries = g_new0(dtbl_entry_t *, sub_dissectors->flat_len);
+	} else {
+		sub_dissectors->flat_len = 0;
+		sub_dissectors->flat_entries = NULL;
+	}
+	sub_dissectors->flat_dirty = FALSE;
 	g_hash_table_insert(dissector_tables, (gpointer)name, (gpointer) sub_dissectors);
 	return sub_dissectors;
 }
@@ -2534,6 +2631,9 @@ dissector_table_t register_custom_dissector_table(const char *name,
 	sub_dissectors->param   = BASE_NONE;
 	sub_dissectors->protocol  = find_protocol_by_id(proto);
 	sub_dissectors->supports_decode_as = FALSE;
+	sub_dissectors->flat_entries = NULL;
+	sub_dissectors->flat_len = 0;
+	sub_dissectors->flat_dirty = FALSE;
 	g_hash_table_insert(dissector_tables, (gpointer)name, (gpointer) sub_dissectors);
 	return sub_dissectors;
 }
@@ -2701,6 +2801,9 @@ heur_dissector_add(const char *name, heur_dissector_t dissector, const char *dis
 	hdtbl_entry->short_name = g_strdup(internal_name);
 	hdtbl_entry->list_name = g_strdup(name);
 	hdtbl_entry->enabled   = (enable == HEURISTIC_ENABLE);
+	hdtbl_entry->calls     = 0;
+	hdtbl_entry->accepts   = 0;
+	hdtbl_entry->conv_hits = 0;
 
 	/* do the table insertion */
 	g_hash_table_insert(heuristic_short_names, (gpointer)hdtbl_entry->short_name, hdtbl_entry);
@@ -2729,6 +2832,18 @@ find_matching_heur_dissector(gconstpointer a, gconstpointer b) {
 		(hdtbl_entry_a->protocol == hdtbl_entry_b->protocol) ? 0 : 1;
 }
 
+/* Forget which heuristic last accepted each conversation. */
+static void
+heur_conv_cache_clear(struct heur_dissector_list *sub_dissectors)
+{
+	wmem_list_t       *convs = wmem_map_get_keys(NULL, sub_dissectors->conv_cache);
+	wmem_list_frame_t *frame;
+
+	for (frame = wmem_list_head(convs); frame; frame = wmem_list_frame_next(frame))
+		wmem_map_remove(sub_dissectors->conv_cache, wmem_list_frame_data(frame));
+	wmem_destroy_list(convs);
+}
+
 void
 heur_dissector_delete(const char *name, heur_dissector_t dissector, const int proto) {
 	heur_dissector_list_t  sub_dissectors = find_heur_dissector_list(name);
@@ -2752,7 +2867,76 @@ heur_dissector_delete(const char *name, heur_dissector_t dissector, const int pr
 		g_slice_free(heur_dtbl_entry_t, found_entry->data);
 		sub_dissectors->dissectors = g_slist_delete_link(sub_dissectors->dissectors,
 		    found_entry);
+		heur_conv_cache_clear(sub_dissectors);
+	}
+}
+
+/*
+ * Is this heuristic dissector one that may be tried?
+ */
+static inline gboolean
+heur_dissector_entry_enabled(const heur_dtbl_entry_t *hdtbl_entry)
+{
+	return hdtbl_entry->protocol == NULL ||
+		(proto_is_protocol_enabled(hdtbl_entry->protocol) && hdtbl_entry->enabled);
+}
+
+/*
+ * Call a single heuristic dissector, adding its protocol to the layers
+ * and removing it again if it rejected the packet.
+ */
+static int
+call_heur_dissector_entry(heur_dtbl_entry_t *hdtbl_entry, tvbuff_t *tvb,
+			  packet_info *pinfo, proto_tree *tree, void *data,
+			  guint saved_layers_len, guint saved_tree_count)
+{
+	int proto_id;
+	int len;
+
+	if (hdtbl_entry->protocol != NULL) {
+		proto_id = proto_get_id(hdtbl_entry->protocol);
+		/* do NOT change this behavior - wslua uses the protocol short name set here in order
+		   to determine which Lua-based heurisitc dissector to call */
+		pinfo->current_proto =
+			proto_get_protocol_short_name(hdtbl_entry->protocol);
+
+		/*
+		 * Add the protocol name to the layers; we'll remove it
+		 * if the dissector fails.
+		 */
+		pinfo->curr_layer_num++;
+		wmem_list_append(pinfo->layers, GINT_TO_POINTER(proto_id));
 	}
+
+	pinfo->heur_list_name = hdtbl_entry->list_name;
+
+	if (!PINFO_FD_VISITED(pinfo))
+		hdtbl_entry->calls++;
+	len = (hdtbl_entry->dissector)(tvb, pinfo, tree, data);
+	if (hdtbl_entry->protocol != NULL &&
+		(len == 0 || (tree && saved_tree_count == tree->tree_data->count))) {
+		/*
+		 * We added a protocol layer above. The dissector
+		 * didn't accept the packet or it didn't add any
+		 * items to the tree so remove it from the list.
+		 */
+		while (wmem_list_count(pinfo->layers) > saved_layers_len) {
+			if (len == 0) {
+				/*
+				 * Only reduce the layer number if the dissector
+				 * rejected the data. Since tree can be NULL on
+				 * the first pass, we cannot check it or it will
+				 * break dissectors that rely on a stable value.
+				 */
+				pinfo->curr_layer_num--;
+			}
+			wmem_list_remove_frame(pinfo->layers, wmem_list_tail(pinfo->layers));
+		}
+	}
+	if (len && !PINFO_FD_VISITED(pinfo))
+		hdtbl_entry->accepts++;
+
+	return len;
 }
 
 gboolean
@@ -2767,8 +2951,8 @@ dissector_try_heuristic(heur_dissector_list_t sub_dissectors, tvbuff_t *tvb,
 	guint16            saved_can_desegment;
 	guint              saved_layers_len = 0;
 	heur_dtbl_entry_t *hdtbl_entry;
-	int                proto_id;
-	int                len;
+	heur_dtbl_entry_t *cached_entry = NULL;
+	conversation_t    *conv = NULL;
 	guint              saved_tree_count = tree ? tree->tree_data->count : 0;
 
 	/* can_desegment is set to 2 by anyone which offers this api/service.
@@ -2793,59 +2977,56 @@ dissector_try_heuristic(heur_dissector_list_t sub_dissectors, tvbuff_t *tvb,
 
 	DISSECTOR_ASSERT(saved_layers_len < PINFO_LAYER_MAX_RECURSION_DEPTH);
 
+	/*
+	 * If there is more than one heuristic to choose from, first try
+	 * the one that last accepted a packet in this conversation, if
+	 * there is one; traffic in a conversation is usually all the same
+	 * protocol, so this saves walking the whole list.  Only use the
+	 * cached entry if it is still enabled; heur_dissector_delete()
+	 * clears the cache of its list.
+	 */
+	if (sub_dissectors->dissectors != NULL && sub_dissectors->dissectors->next != NULL) {
+		conv = find_conversation_pinfo(pinfo, 0);
+		if (conv != NULL) {
+			cached_entry = (heur_dtbl_entry_t *)wmem_map_lookup(sub_dissectors->conv_cache, conv);
+			if (cached_entry != NULL && !heur_dissector_entry_enabled(cached_entry)) {
+				wmem_map_remove(sub_dissectors->conv_cache, conv);
+				cached_entry = NULL;
+			}
+		}
+	}
+
+	if (cached_entry != NULL) {
+		if (call_heur_dissector_entry(cached_entry, tvb, pinfo, tree, data,
+					      saved_layers_len, saved_tree_count)) {
+			if (!PINFO_FD_VISITED(pinfo))
+				cached_entry->conv_hits++;
+			*heur_dtbl_entry = cached_entry;
+			pinfo->current_proto = saved_curr_proto;
+			pinfo->heur_list_name = saved_heur_list_name;
+			pinfo->can_desegment = saved_can_desegment;
+			return TRUE;
+		}
+		/* It no longer likes this conversation; forget it. */
+		wmem_map_remove(sub_dissectors->conv_cache, conv);
+	}
+
 	for (entry = sub_dissectors->dissectors; entry != NULL;
 	    entry = g_slist_next(entry)) {
 		/* XXX - why set this now and above? */
 		pinfo->can_desegment = saved_can_desegment-(saved_can_desegment>0);
 		hdtbl_entry = (heur_dtbl_entry_t *)entry->data;
 
-		if (hdtbl_entry->protocol != NULL &&
-			(!proto_is_protocol_enabled(hdtbl_entry->protocol)||(hdtbl_entry->enabled==FALSE))) {
+		if (hdtbl_entry == cached_entry || !heur_dissector_entry_enabled(hdtbl_entry)) {
 			/*
-			 * No - don't try this dissector.
+			 * No - don't try this dissector (again).
 			 */
+			prev_entry = entry;
 			continue;
 		}
 
-		if (hdtbl_entry->protocol != NULL) {
-			proto_id = proto_get_id(hdtbl_entry->protocol);
-			/* do NOT change this behavior - wslua uses the protocol short name set here in order
-			   to determine which Lua-based heurisitc dissector to call */
-			pinfo->current_proto =
-				proto_get_protocol_short_name(hdtbl_entry->protocol);
-
-			/*
-			 * Add the protocol name to the layers; we'll remove it
-			 * if the dissector fails.
-			 */
-			pinfo->curr_layer_num++;
-			wmem_list_append(pinfo->layers, GINT_TO_POINTER(proto_id));
-		}
-
-		pinfo->heur_list_name = hdtbl_entry->list_name;
-
-		len = (hdtbl_entry->dissector)(tvb, pinfo, tree, data);
-		if (hdtbl_entry->protocol != NULL &&
-			(len == 0 || (tree && saved_tree_count == tree->tree_data->count))) {
-			/*
-			 * We added a protocol layer above. The dissector
-			 * didn't accept the packet or it didn't add any
-			 * items to the tree so remove it from the list.
-			 */
-			while (wmem_list_count(pinfo->layers) > saved_layers_len) {
-				if (len == 0) {
-					/*
-					 * Only reduce the layer number if the dissector
-					 * rejected the data. Since tree can be NULL on
-					 * the first pass, we cannot check it or it will
-					 * break dissectors that rely on a stable value.
-					 */
-					pinfo->curr_layer_num--;
-				}
-				wmem_list_remove_frame(pinfo->layers, wmem_list_tail(pinfo->layers));
-			}
-		}
-		if (len) {
+		if (call_heur_dissector_entry(hdtbl_entry, tvb, pinfo, tree, data,
+					      saved_layers_len, saved_tree_count)) {
 			*heur_dtbl_entry = hdtbl_entry;
 
 			/* Bubble the matched entry to the top for faster search next time. */
@@ -2853,6 +3034,9 @@ dissector_try_heuristic(heur_dissector_list_t sub_dissectors, tvbuff_t *tvb,
 				sub_dissectors->dissectors = g_slist_remove_link(sub_dissectors->dissectors, entry);
 				sub_dissectors->dissectors = g_slist_concat(entry, sub_dissectors->dissectors);
 			}
+			/* And remember it for the rest of the conversation. */
+			if (conv != NULL)
+				wmem_map_insert(sub_dissectors->conv_cache, conv, hdtbl_entry);
 			status = TRUE;
 			break;
 		}
@@ -2865,6 +3049,25 @@ dissector_try_heuristic(heur_dissector_list_t sub_dissectors, tvbuff_t *tvb,
 	return status;
 }
 
+static void
+heur_conv_cache_forget(gpointer key _U_, gpointer value, gpointer user_data)
+{
+	struct heur_dissector_list *sub_dissectors = (struct heur_dissector_list *)value;
+
+	wmem_map_remove(sub_dissectors->conv_cache, user_data);
+}
+
+/*
+ * Called when a conversation is freed before the end of the file, so that
+ * its address is not found in the heuristic caches, neither for itself nor
+ * for a new conversation allocated at the same address.
+ */
+void
+packet_forget_conversation(conversation_t *conv)
+{
+	g_hash_table_foreach(heur_dissector_lists, heur_conv_cache_forget, conv);
+}
+
 typedef struct heur_dissector_foreach_info {
 	gpointer      caller_data;
 	DATFunc_heur  caller_func;
@@ -3013,6 +3216,8 @@ register_heur_dissector_list(const char *name, const int proto)
 	sub_dissectors = g_slice_new(struct heur_dissector_list);
 	sub_dissectors->protocol  = find_protocol_by_id(proto);
 	sub_dissectors->dissectors = NULL;	/* initially empty */
+	sub_dissectors->conv_cache = wmem_map_new_autoreset(wmem_epan_scope(), wmem_file_scope(),
+	    g_direct_hash, g_direct_equal);
 	g_hash_table_insert(heur_dissector_lists, (gpointer)name,
 			    (gpointer) sub_dissectors);
 	return sub_dissectors;
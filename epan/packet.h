@@ -51,6 +51,10 @@ extern void packet_init(void);
 extern void packet_cache_proto_handles(void);
 extern void packet_cleanup(void);
 
+/* Forget per-conversation state of the dissection engine, for conversation.c */
+struct conversation;
+extern void packet_forget_conversation(struct conversation *conv);
+
 /* Handle for dissectors you call directly or register with "dissector_add_uint()".
    This handle is opaque outside of "packet.c". */
 struct dissector_handle;
@@ -423,6 +427,14 @@ WS_DLL_PUBLIC ftenum_t dissector_table_get_type(dissector_table_t dissector_tabl
  */
 WS_DLL_PUBLIC void dissector_table_allow_decode_as(dissector_table_t dissector_table);
 
+/** Look up values in an FT_UINT8 or FT_UINT16 dissector table through an
+ *  array indexed directly by value instead of through its hash table.
+ *  This trades memory (a pointer per possible value) for speed, so it is
+ *  meant for busy tables with dense key spaces such as port numbers;
+ *  FT_UINT8 tables always do this.
+ */
+WS_DLL_PUBLIC void dissector_table_use_flat_lookup(dissector_table_t dissector_table);
+
 /* List of "heuristic" dissectors (which get handed a packet, look at it,
    and either recognize it as being for their protocol, dissect it, and
    return TRUE, or don't recognize it and return FALSE) to be called
@@ -440,6 +452,10 @@ typedef struct heur_dtbl_entry {
 	const gchar *display_name;     /* the string used to present heuristic to user */
 	gchar *short_name;     /* string used for "internal" use to uniquely identify heuristic */
 	gboolean enabled;
+	/* Counted on the first pass over the current file only */
+	guint64 calls;         /* number of times this heuristic was tried */
+	guint64 accepts;       /* number of times this heuristic accepted the packet */
+	guint64 conv_hits;     /* number of accepts found via the per-conversation cache */
 } heur_dtbl_entry_t;
 
 /** A protocol uses this function to register a heuristic sub-dissector list.
@@ -3752,6 +3752,22 @@ prefs_register_modules(void)
                                    "Currently only ICMP and ICMPv6 use this preference to add VLAN ID to conversation tracking",
                                    &prefs.strict_conversation_tracking_heuristics);
 
+    prefs_register_uint_preference(protocols_module, "conversation_idle_timeout",
+                                   "Evict conversations idle for (seconds)",
+                                   "Free conversations and their protocol data after they have seen no packets for this many seconds. "
+                                   "Only for single-pass live capture, e.g. TShark without -2; packets cannot be re-dissected afterwards. "
+                                   "0 disables idle eviction.",
+                                   10,
+                                   &prefs.conversation_idle_timeout);
+
+    prefs_register_uint_preference(protocols_module, "conversation_limit",
+                                   "Maximum number of conversations",
+                                   "Free the least recently active conversations when more than this many are tracked. "
+                                   "Only for single-pass live capture, e.g. TShark without -2; packets cannot be re-dissected afterwards. "
+                                   "0 means no limit.",
+                                   10,
+                                   &prefs.conversation_limit);
+
     /* Obsolete preferences
      * These "modules" were reorganized/renamed to correspond to their GUI
      * configuration screen within the preferences dialog
@@ -4264,6 +4280,8 @@ pre_init_prefs(void)
     prefs.st_sort_showfullname = FALSE;
     prefs.display_hidden_proto_items = FALSE;
     prefs.display_byte_fields_with_spaces = FALSE;
+    prefs.conversation_idle_timeout = 0;
+    prefs.conversation_limit = 0;
 }
 
 /*
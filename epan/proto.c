@@ -403,6 +403,28 @@ typedef struct _gpa_hfinfo_t {
 
 static gpa_hfinfo_t gpa_hfinfo;
 
+/* Dense slot, plus one, of every field that has ever been primed (0 if it
+ * never was). Slots are handed out in priming order and never reused, so a
+ * tree only needs as many interesting_hfids entries as there are primed
+ * fields, rather than one per registered field. */
+static guint *interesting_slots;
+static guint  interesting_slots_len;
+static guint  interesting_slot_count;
+
+/*
+ * If set (from the WIRESHARK_DEFER_FIELD_CHECKS environment variable),
+ * the sanity checks on each field's name, abbreviation, type, display
+ * and strings are not done as the field is registered, but only when
+ * proto_check_deferred_fields() is called, e.g. before the field list
+ * is dumped with "tshark -G".  This shortens startup for short-lived
+ * runs; the checks only catch dissector bugs, which the test suite's
+ * "tshark -G" runs still find.
+ */
+static gboolean defer_field_checks = FALSE;
+
+/* Number of entries at the start of gpa_hfinfo that have been checked. */
+static guint fields_checked_len = 0;
+
 /* Hash table of abbreviations and IDs */
 static GHashTable *gpa_name_map = NULL;
 static header_field_info *same_name_hfinfo;
@@ -496,6 +518,8 @@ proto_init(GSList *register_all_plugin_protocols_list,
 	gpa_hfinfo.len           = 0;
 	gpa_hfinfo.allocated_len = 0;
 	gpa_hfinfo.hfi           = NULL;
+	fields_checked_len       = 0;
+	defer_field_checks       = (g_getenv("WIRESHARK_DEFER_FIELD_CHECKS") != NULL);
 	gpa_name_map             = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, save_same_name_hfinfo);
 	gpa_protocol_aliases     = g_hash_table_new(g_str_hash, g_str_equal);
 	deregistered_fields      = g_ptr_array_new();
@@ -631,6 +655,11 @@ proto_cleanup_base(void)
 	g_free(tree_is_expanded);
 	tree_is_expanded = NULL;
 
+	g_free(interesting_slots);
+	interesting_slots      = NULL;
+	interesting_slots_len  = 0;
+	interesting_slot_count = 0;
+
 	if (prefixes)
 		g_hash_table_destroy(prefixes);
 }
@@ -717,10 +746,8 @@ proto_tree_children_foreach(proto_tree *tree, proto_tree_foreach_func func,
 }
 
 static void
-free_GPtrArray_value(gpointer key, gpointer value, gpointer user_data _U_)
+free_GPtrArray_value(gint hfid, GPtrArray *ptrs)
 {
-	GPtrArray         *ptrs = (GPtrArray *)value;
-	gint               hfid = GPOINTER_TO_UINT(key);
 	header_field_info *hfinfo;
 
 	PROTO_REGISTRAR_GET_NTH(hfid, hfinfo);
@@ -740,6 +767,29 @@ free_GPtrArray_value(gpointer key, gpointer value, gpointer user_data _U_)
 	g_ptr_array_free(ptrs, TRUE);
 }
 
+/* Free the GPtrArray's of all the fields that were found while dissecting,
+ * leaving the interesting_hfids table itself allocated so that it can be
+ * reused for the next dissection with the same tree. Only the slots that
+ * were actually filled in are visited. */
+static void
+tree_data_free_interesting_fields(tree_data_t *tree_data)
+{
+	GArray *used = tree_data->interesting_hfids_used;
+	guint   i;
+
+	if (!used)
+		return;
+
+	for (i = 0; i < used->len; i++) {
+		gint  hfid = g_array_index(used, gint, i);
+		guint slot = interesting_slots[hfid] - 1;
+
+		free_GPtrArray_value(hfid, tree_data->interesting_hfids[slot]);
+		tree_data->interesting_hfids[slot] = NULL;
+	}
+	g_array_set_size(used, 0);
+}
+
 static void
 proto_tree_free_node(proto_node *node, gpointer data _U_)
 {
@@ -758,14 +808,7 @@ proto_tree_reset(proto_tree *tree)
 	proto_tree_children_foreach(tree, proto_tree_free_node, NULL);
 
 	/* free tree data */
-	if (tree_data->interesting_hfids) {
-		/* Free all the GPtrArray's in the interesting_hfids hash. */
-		g_hash_table_foreach(tree_data->interesting_hfids,
-			free_GPtrArray_value, NULL);
-
-		/* And then remove all values. */
-		g_hash_table_remove_all(tree_data->interesting_hfids);
-	}
+	tree_data_free_interesting_fields(tree_data);
 
 	/* Reset track of the number of children */
 	tree_data->count = 0;
@@ -782,14 +825,10 @@ proto_tree_free(proto_tree *tree)
 	proto_tree_children_foreach(tree, proto_tree_free_node, NULL);
 
 	/* free tree data */
-	if (tree_data->interesting_hfids) {
-		/* Free all the GPtrArray's in the interesting_hfids hash. */
-		g_hash_table_foreach(tree_data->interesting_hfids,
-			free_GPtrArray_value, NULL);
-
-		/* And then destroy the hash. */
-		g_hash_table_destroy(tree_data->interesting_hfids);
-	}
+	tree_data_free_interesting_fields(tree_data);
+	g_free(tree_data->interesting_hfids);
+	if (tree_data->interesting_hfids_used)
+		g_array_free(tree_data->interesting_hfids_used, TRUE);
 
 	g_slice_free(tree_data_t, tree_data);
 
@@ -2439,22 +2478,34 @@ tree_data_add_maybe_interesting_field(tree_data_t *tree_data, field_info *fi)
 	const header_field_info *hfinfo = fi->hfinfo;
 
 	if (hfinfo->ref_type == HF_REF_TYPE_DIRECT) {
-		GPtrArray *ptrs = NULL;
+		GPtrArray *ptrs;
+		/* Only primed fields are directly referenced, so they have a slot. */
+		guint      slot = interesting_slots[hfinfo->id] - 1;
+
+		if (slot >= tree_data->interesting_hfids_len) {
+			/* Initialize (or grow, if fields were primed since
+			 * the table was created) the table now that we know
+			 * that it is needed; it is indexed by slot. */
+			guint old_len = tree_data->interesting_hfids_len;
+			guint new_len = interesting_slot_count;
 
-		if (tree_data->interesting_hfids == NULL) {
-			/* Initialize the hash because we now know that it is needed */
 			tree_data->interesting_hfids =
-				g_hash_table_new(g_direct_hash, NULL /* g_direct_equal */);
-		} else if (g_hash_table_size(tree_data->interesting_hfids)) {
-			ptrs = (GPtrArray *)g_hash_table_lookup(tree_data->interesting_hfids,
-					   GINT_TO_POINTER(hfinfo->id));
+				(GPtrArray **)g_realloc(tree_data->interesting_hfids,
+							new_len * sizeof(GPtrArray *));
+			memset(tree_data->interesting_hfids + old_len, 0,
+			       (new_len - old_len) * sizeof(GPtrArray *));
+			tree_data->interesting_hfids_len = new_len;
+
+			if (!tree_data->interesting_hfids_used)
+				tree_data->interesting_hfids_used = g_array_new(FALSE, FALSE, sizeof(gint));
 		}
 
+		ptrs = tree_data->interesting_hfids[slot];
 		if (!ptrs) {
 			/* First element triggers the creation of pointer array */
 			ptrs = g_ptr_array_new();
-			g_hash_table_insert(tree_data->interesting_hfids,
-					    GINT_TO_POINTER(hfinfo->id), ptrs);
+			tree_data->interesting_hfids[slot] = ptrs;
+			g_array_append_val(tree_data->interesting_hfids_used, hfinfo->id);
 		}
 
 		g_ptr_array_add(ptrs, fi);
@@ -7121,6 +7172,8 @@ proto_tree_create_root(packet_info *pinfo)
 
 	/* Don't initialize the tree_data_t. Wait until we know we need it */
 	pnode->tree_data->interesting_hfids = NULL;
+	pnode->tree_data->interesting_hfids_len = 0;
+	pnode->tree_data->interesting_hfids_used = NULL;
 
 	/* Set the default to FALSE so it's easier to
 	 * find errors; if we expect to see the protocol tree
@@ -7150,6 +7203,19 @@ proto_tree_prime_with_hfid(proto_tree *tree _U_, const gint hfid)
 	   also increase the refcount for the parent, i.e the protocol.
 	*/
 	hfinfo->ref_type = HF_REF_TYPE_DIRECT;
+
+	/* Give the field a slot in the interesting_hfids of the trees. */
+	if ((guint)hfid >= interesting_slots_len) {
+		guint new_len = MAX(gpa_hfinfo.len, (guint)hfid + 1);
+
+		interesting_slots = g_renew(guint, interesting_slots, new_len);
+		memset(interesting_slots + interesting_slots_len, 0,
+		       (new_len - interesting_slots_len) * sizeof(guint));
+		interesting_slots_len = new_len;
+	}
+	if (interesting_slots[hfid] == 0)
+		interesting_slots[hfid] = ++interesting_slot_count;
+
 	/* only increase the refcount if there is a parent.
 	   if this is a protocol and not a field then parent will be -1
 	   and there is no parent to add any refcounting for.
@@ -8791,11 +8857,52 @@ register_string_errors(void)
 }
 
 #define PROTO_PRE_ALLOC_HF_FIELDS_MEM (231000+PRE_ALLOC_EXPERT_FIELDS_MEM)
+/* Check that the filter name (abbreviation) is legal;
+ * it must contain only alphanumerics, '-', "_", and ".". */
+static void
+proto_check_field_abbrev(const header_field_info *hfinfo)
+{
+	guchar c;
+
+	c = proto_check_field_name(hfinfo->abbrev);
+	if (c) {
+		if (c == '.') {
+			fprintf(stderr, "Invalid leading, duplicated or trailing '.' found in filter name '%s'\n", hfinfo->abbrev);
+		} else if (g_ascii_isprint(c)) {
+			fprintf(stderr, "Invalid character '%c' in filter name '%s'\n", c, hfinfo->abbrev);
+		} else {
+			fprintf(stderr, "Invalid byte \\%03o in filter name '%s'\n", c, hfinfo->abbrev);
+		}
+		DISSECTOR_ASSERT_NOT_REACHED();
+	}
+}
+
+/*
+ * Run the registration-time sanity checks on any fields that were
+ * registered while defer_field_checks was set. Fields with an id below
+ * fields_checked_len have already been checked.
+ */
+void
+proto_check_deferred_fields(void)
+{
+	header_field_info *hfinfo;
+
+	for (; fields_checked_len < gpa_hfinfo.len; fields_checked_len++) {
+		hfinfo = gpa_hfinfo.hfi[fields_checked_len];
+		if (hfinfo == NULL)
+			continue;
+		tmp_fld_check_assert(hfinfo);
+		if ((hfinfo->name[0] != 0) && (hfinfo->abbrev[0] != 0 ))
+			proto_check_field_abbrev(hfinfo);
+	}
+}
+
 static int
 proto_register_field_init(header_field_info *hfinfo, const int parent)
 {
 
-	tmp_fld_check_assert(hfinfo);
+	if (!defer_field_checks)
+		tmp_fld_check_assert(hfinfo);
 
 	hfinfo->parent         = parent;
 	hfinfo->same_name_next = NULL;
@@ -8817,25 +8924,16 @@ proto_register_field_init(header_field_info *hfinfo, const int parent)
 	gpa_hfinfo.len++;
 	hfinfo->id = gpa_hfinfo.len - 1;
 
+	if (!defer_field_checks)
+		fields_checked_len = gpa_hfinfo.len;
+
 	/* if we have real names, enter this field in the name tree */
 	if ((hfinfo->name[0] != 0) && (hfinfo->abbrev[0] != 0 )) {
 
 		header_field_info *same_name_next_hfinfo;
-		guchar c;
-
-		/* Check that the filter name (abbreviation) is legal;
-		 * it must contain only alphanumerics, '-', "_", and ".". */
-		c = proto_check_field_name(hfinfo->abbrev);
-		if (c) {
-			if (c == '.') {
-				fprintf(stderr, "Invalid leading, duplicated or trailing '.' found in filter name '%s'\n", hfinfo->abbrev);
-			} else if (g_ascii_isprint(c)) {
-				fprintf(stderr, "Invalid character '%c' in filter name '%s'\n", c, hfinfo->abbrev);
-			} else {
-				fprintf(stderr, "Invalid byte \\%03o in filter name '%s'\n", c, hfinfo->abbrev);
-			}
-			DISSECTOR_ASSERT_NOT_REACHED();
-		}
+
+		if (!defer_field_checks)
+			proto_check_field_abbrev(hfinfo);
 
 		/* We allow multiple hfinfo's to be registered under the same
 		 * abbreviation. This was done for X.25, as, depending
@@ -10409,24 +10507,27 @@ proto_get_finfo_ptr_array(const proto_tree *tree, const int id)
 	if (!tree)
 		return NULL;
 
-	if (PTREE_DATA(tree)->interesting_hfids != NULL)
-		return (GPtrArray *)g_hash_table_lookup(PTREE_DATA(tree)->interesting_hfids,
-					   GINT_TO_POINTER(id));
-	else
-		return NULL;
+	if (id >= 0 && (guint)id < interesting_slots_len) {
+		guint slot = interesting_slots[id] - 1;
+
+		/* (guint)-1, and out of range, if the field was never primed */
+		if (slot < PTREE_DATA(tree)->interesting_hfids_len)
+			return PTREE_DATA(tree)->interesting_hfids[slot];
+	}
+	return NULL;
 }
 
 gboolean
 proto_tracking_interesting_fields(const proto_tree *tree)
 {
-	GHashTable *interesting_hfids;
+	GArray *interesting_hfids_used;
 
 	if (!tree)
 		return FALSE;
 
-	interesting_hfids = PTREE_DATA(tree)->interesting_hfids;
+	interesting_hfids_used = PTREE_DATA(tree)->interesting_hfids_used;
 
-	return (interesting_hfids != NULL) && g_hash_table_size(interesting_hfids);
+	return (interesting_hfids_used != NULL) && interesting_hfids_used->len;
 }
 
 /* Helper struct for proto_find_info() and	proto_all_finfos() */
@@ -10696,6 +10797,8 @@ proto_registrar_dump_values(void)
 	const true_false_string	*tfs;
 	const unit_name_string	*units;
 
+	proto_check_deferred_fields();
+
 	len = gpa_hfinfo.len;
 	for (i = 0; i < len ; i++) {
 		if (gpa_hfinfo.hfi[i] == NULL)
@@ -11180,6 +11283,8 @@ proto_registrar_dump_fields(void)
 	const char	  *blurb;
 	char		   width[5];
 
+	proto_check_deferred_fields();
+
 	len = gpa_hfinfo.len;
 	for (i = 0; i < len ; i++) {
 		if (gpa_hfinfo.hfi[i] == NULL)
@@ -856,7 +856,9 @@ typedef struct
 /** One of these exists for the entire protocol tree. Each proto_node
  * in the protocol tree points to the same copy. */
 typedef struct {
-    GHashTable          *interesting_hfids;
+    GPtrArray          **interesting_hfids;     /**< field_info arrays, indexed by the slot of each primed field */
+    guint                interesting_hfids_len; /**< allocated length of interesting_hfids */
+    GArray              *interesting_hfids_used; /**< hfids with a non-NULL interesting_hfids entry */
     gboolean             visible;
     gboolean             fake_protocols;
     guint                count;
@@ -2715,6 +2717,10 @@ WS_DLL_PUBLIC GPtrArray* proto_find_first_finfo(proto_tree *tree, const int hfin
  @return GPtrArry pointer */
 WS_DLL_PUBLIC GPtrArray* proto_all_finfos(proto_tree *tree);
 
+/** Run the field sanity checks that were skipped at registration time
+    because WIRESHARK_DEFER_FIELD_CHECKS was set. Does nothing otherwise. */
+WS_DLL_PUBLIC void proto_check_deferred_fields(void);
+
 /** Dumps a glossary of the protocol registrations to STDOUT */
 WS_DLL_PUBLIC void proto_registrar_dump_protocols(void);
 
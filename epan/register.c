@@ -11,6 +11,9 @@
 #include "register-int.h"
 #include "ws_attributes.h"
 
+#include <stdio.h>
+#include <stdlib.h>
+
 #include <glib.h>
 #include "epan/dissectors/dissectors.h"
 
@@ -22,18 +25,78 @@ static GAsyncQueue *register_cb_done_q;
 
 #define CB_WAIT_TIME (150 * 1000) // microseconds
 
+/*
+ * If the WIRESHARK_DEBUG_REGISTRATION_TIMES environment variable is set,
+ * the time taken by each built-in register and handoff routine is kept
+ * here and a report of the slowest ones is written to stderr once all
+ * handoffs are done.
+ */
+typedef struct {
+    const char *cb_name;
+    gint64      usecs;
+} register_time_t;
+
+static register_time_t *register_times;
+static register_time_t *handoff_times;
+
 static void set_cb_name(const char *proto) {
     g_mutex_lock(&cur_cb_name_mtx);
     cur_cb_name = proto;
     g_mutex_unlock(&cur_cb_name_mtx);
 }
 
+static void
+call_reg_func(const dissector_reg_t *reg, register_time_t *time_entry)
+{
+    gint64 start;
+
+    set_cb_name(reg->cb_name);
+    if (!time_entry) {
+        reg->cb_func();
+        return;
+    }
+
+    start = g_get_monotonic_time();
+    reg->cb_func();
+    time_entry->cb_name = reg->cb_name;
+    time_entry->usecs = g_get_monotonic_time() - start;
+}
+
+static int
+compare_register_times(const void *a, const void *b)
+{
+    const register_time_t *time_a = (const register_time_t *)a;
+    const register_time_t *time_b = (const register_time_t *)b;
+
+    if (time_a->usecs != time_b->usecs)
+        return (time_a->usecs < time_b->usecs) ? 1 : -1;
+    return 0;
+}
+
+#define REGISTER_TIMES_REPORTED 25
+
+static void
+report_register_times(const char *what, register_time_t *times, gulong count)
+{
+    gint64 total = 0;
+    gulong i;
+
+    for (i = 0; i < count; i++)
+        total += times[i].usecs;
+
+    qsort(times, count, sizeof(register_time_t), compare_register_times);
+
+    fprintf(stderr, "%s: %lu routines, %.3f ms total\n", what, count, total / 1000.0);
+    for (i = 0; i < count && i < REGISTER_TIMES_REPORTED; i++) {
+        fprintf(stderr, "  %10.3f ms  %s\n", times[i].usecs / 1000.0, times[i].cb_name);
+    }
+}
+
 static void *
 register_all_protocols_worker(void *arg _U_)
 {
     for (gulong i = 0; i < dissector_reg_proto_count; i++) {
-        set_cb_name(dissector_reg_proto[i].cb_name);
-        dissector_reg_proto[i].cb_func();
+        call_reg_func(&dissector_reg_proto[i], register_times ? &register_times[i] : NULL);
     }
 
     g_async_queue_push(register_cb_done_q, GINT_TO_POINTER(TRUE));
@@ -48,6 +111,11 @@ register_all_protocols(register_cb cb, gpointer cb_data)
     gboolean called_back = FALSE;
     GThread *rapw_thread;
 
+    if (g_getenv("WIRESHARK_DEBUG_REGISTRATION_TIMES") != NULL) {
+        register_times = g_new0(register_time_t, dissector_reg_proto_count);
+        handoff_times = g_new0(register_time_t, dissector_reg_handoff_count);
+    }
+
     rapw_thread = g_thread_new("register_all_protocols_worker", &register_all_protocols_worker, NULL);
     while (!g_async_queue_timeout_pop(register_cb_done_q, CB_WAIT_TIME)) {
         g_mutex_lock(&cur_cb_name_mtx);
@@ -68,8 +136,7 @@ static void *
 register_all_protocol_handoffs_worker(void *arg _U_)
 {
     for (gulong i = 0; i < dissector_reg_handoff_count; i++) {
-        set_cb_name(dissector_reg_handoff[i].cb_name);
-        dissector_reg_handoff[i].cb_func();
+        call_reg_func(&dissector_reg_handoff[i], handoff_times ? &handoff_times[i] : NULL);
     }
 
     g_async_queue_push(register_cb_done_q, GINT_TO_POINTER(TRUE));
@@ -99,6 +166,15 @@ register_all_protocol_handoffs(register_cb cb, gpointer cb_data)
         cb(RA_HANDOFF, "finished", cb_data);
     }
     g_async_queue_unref(register_cb_done_q);
+
+    if (register_times) {
+        report_register_times("Protocol registration", register_times, dissector_reg_proto_count);
+        report_register_times("Protocol handoff", handoff_times, dissector_reg_handoff_count);
+        g_free(register_times);
+        g_free(handoff_times);
+        register_times = NULL;
+        handoff_times = NULL;
+    }
 }
 
 gulong register_count(void)
@@ -400,6 +400,8 @@ cf_close(capture_file *cf)
 
   dfilter_free(cf->rfcode);
   cf->rfcode = NULL;
+  g_free(cf->rescan_dfilter);
+  cf->rescan_dfilter = NULL;
   if (cf->provider.frames != NULL) {
     free_frame_data_sequence(cf->provider.frames);
     cf->provider.frames = NULL;
@@ -719,6 +721,12 @@ cf_read(capture_file *cf, gboolean reloading)
   g_assert(cf->read_lock);
   cf->read_lock = FALSE;
 
+  /* Every frame read was filtered with the current filter, unless it changed meanwhile. */
+  if (cf->redissection_queued == RESCAN_NONE) {
+    g_free(cf->rescan_dfilter);
+    cf->rescan_dfilter = g_strdup(cf->dfilter);
+  }
+
   if (is_read_aborted) {
     /*
      * Well, the user decided to exit Wireshark while reading this *offline*
@@ -1537,6 +1545,9 @@ cf_filter_packets(capture_file *cf, gchar *dftext, gboolean force)
   if (cf->redissection_queued == RESCAN_NONE) {
     if (cf->read_lock) {
       cf->redissection_queued = RESCAN_SCAN;
+      /* Frames read until the rescan runs are filtered with the new filter. */
+      g_free(cf->rescan_dfilter);
+      cf->rescan_dfilter = NULL;
     } else if (cf->state != FILE_CLOSED) {
       if (dftext == NULL) {
         rescan_packets(cf, "Resetting", "filter", FALSE);
@@ -1652,6 +1663,7 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, gb
   gboolean    compiled;
   guint32     frames_count;
   gboolean    queued_rescan_type = RESCAN_NONE;
+  gboolean    refine, skip_frame;
 
   /* Rescan in progress, clear pending actions. */
   cf->redissection_queued = RESCAN_NONE;
@@ -1693,6 +1705,18 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, gb
      (redissect && postdissectors_want_hfids()));
 
   reset_tap_listeners();
+
+  /*
+   * If every frame was last filtered with a filter that the new one only
+   * narrows down, frames which didn't pass that can't pass this one either,
+   * so there is no need to read and dissect them again - unless a tap
+   * listener wants to see every frame.
+   */
+  refine = !redissect && dfilter_text_refines(cf->dfilter, cf->rescan_dfilter) &&
+           !tap_listeners_require_dissection();
+  g_free(cf->rescan_dfilter);
+  cf->rescan_dfilter = NULL;
+
   /* Which frame, if any, is the currently selected frame?
      XXX - should the selected frame or the focus frame be the "current"
      frame, that frame being the one from which "Find Frame" searches
@@ -1864,8 +1888,15 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, gb
     /* Frame dependencies from the previous dissection/filtering are no longer valid. */
     fdata->dependent_of_displayed = 0;
 
-    if (!cf_read_record(cf, fdata, &rec, &buf))
+    skip_frame = refine && !fdata->passed_dfilter && !fdata->ref_time;
+    if (skip_frame) {
+      /* Didn't pass the filter this one refines; just keep the time references right. */
+      frame_data_set_before_dissect(fdata, &cf->elapsed_time,
+                                    &cf->provider.ref, cf->provider.prev_dis);
+      cf->provider.prev_cap = fdata;
+    } else if (!cf_read_record(cf, fdata, &rec, &buf)) {
       break; /* error reading the frame */
+    }
 
     /* If the previous frame is displayed, and we haven't yet seen the
        selected frame, remember that frame - it's the closest one we've
@@ -1875,9 +1906,11 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, gb
       preceding_frame = prev_frame;
     }
 
-    add_packet_to_packet_list(fdata, cf, &edt, dfcode,
-                                    cinfo, &rec, &buf,
-                                    add_to_packet_list);
+    if (!skip_frame) {
+      add_packet_to_packet_list(fdata, cf, &edt, dfcode,
+                                      cinfo, &rec, &buf,
+                                      add_to_packet_list);
+    }
 
     /* If this frame is displayed, and this is the first frame we've
        seen displayed after the selected frame, remember this frame -
@@ -1903,6 +1936,10 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, gb
   wtap_rec_cleanup(&rec);
   ws_buffer_free(&buf);
 
+  /* Only a complete pass leaves every frame filtered with the current filter. */
+  if (framenum > frames_count && queued_rescan_type == RESCAN_NONE && !cf->stop_flag)
+    cf->rescan_dfilter = g_strdup(cf->dfilter);
+
   /* We are done redissecting the packet list. */
   cf->redissecting = FALSE;
 
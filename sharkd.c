@@ -18,6 +18,11 @@
 #include <errno.h>
 #include <signal.h>
 
+#ifndef _WIN32
+#include <unistd.h>
+#include <sys/wait.h>
+#endif
+
 #include <glib.h>
 
 #include <epan/exceptions.h>
@@ -70,8 +75,14 @@
 
 capture_file cfile;
 
+#define SHARKD_FILTER_MAX_WORKERS          64
+/* Below this, forking costs more than filtering the file serially. */
+#define SHARKD_FILTER_PARALLEL_MIN_FRAMES  100000
+
 static guint32 cum_bytes;
 static frame_data ref_frame;
+static guint filter_workers = 1;
+static gboolean preloaded = FALSE;
 
 static void sharkd_cmdarg_err(const char *msg_format, va_list ap);
 static void sharkd_cmdarg_err_cont(const char *msg_format, va_list ap);
@@ -481,6 +492,8 @@ sharkd_cmdarg_err_cont(const char *msg_format, va_list ap)
 cf_status_t
 sharkd_cf_open(const char *fname, unsigned int type, gboolean is_tempfile, int *err)
 {
+  /* Whatever was preloaded is replaced now. */
+  preloaded = FALSE;
   return cf_open(&cfile, fname, type, is_tempfile, err);
 }
 
@@ -490,6 +503,60 @@ sharkd_load_cap_file(void)
   return load_cap_file(&cfile, 0, 0);
 }
 
+/*
+ * Load a capture file in the daemon itself, so that the sessions forked
+ * from it start with the first pass already done and share its frame
+ * data, conversations and reassembly tables copy-on-write.
+ */
+int
+sharkd_preload_cap_file(const char *fname)
+{
+  int err = 0;
+
+  if (sharkd_cf_open(fname, WTAP_TYPE_AUTO, FALSE, &err) != CF_OK)
+    return err ? err : -1;
+
+  err = sharkd_load_cap_file();
+  if (err == 0)
+    preloaded = TRUE;
+
+  return err;
+}
+
+gboolean
+sharkd_is_preloaded(const char *fname)
+{
+  return preloaded && g_strcmp0(cfile.filename, fname) == 0;
+}
+
+/*
+ * The first pass of the preloaded file no longer matches the session
+ * (e.g. a preference was changed), so loading it must redissect.
+ */
+void
+sharkd_forget_preloaded(void)
+{
+  preloaded = FALSE;
+}
+
+/*
+ * Give a forked process its own random-access descriptor; the inherited
+ * one shares its file offset with the parent and every other child.
+ */
+int
+sharkd_reopen_cap_file(void)
+{
+  int err = 0;
+
+  if (cfile.provider.wth == NULL)
+    return 0;
+
+  if (!wtap_fdreopen(cfile.provider.wth, cfile.filename, &err))
+    return err;
+
+  return 0;
+}
+
 frame_data *
 sharkd_get_frame(guint32 framenum)
 {
@@ -679,50 +746,32 @@ sharkd_retap(void)
   return 0;
 }
 
-int
-sharkd_filter(const char *dftext, guint8 **result)
+/*
+ * Filter frames [first, last] into result_bits (frame n is bit n % 8 of
+ * byte n / 8); returns the number of frames that passed.
+ */
+static guint32
+sharkd_filter_range(dfilter_t *dfcode, guint32 first, guint32 last, const guint8 *candidates, guint8 *result_bits)
 {
-  dfilter_t  *dfcode = NULL;
-
   guint32 framenum, prev_dis_num = 0;
-  guint32 frames_count;
+  guint32 passed_count = 0;
   Buffer buf;
   wtap_rec rec;
   int err;
   char *err_info = NULL;
 
-  guint8 *result_bits;
-  guint8  passed_bits;
-
   epan_dissect_t edt;
 
-  if (!dfilter_compile(dftext, &dfcode, &err_info)) {
-    g_free(err_info);
-    return -1;
-  }
-
-  /* if dfilter_compile() success, but (dfcode == NULL) all frames are matching */
-  if (dfcode == NULL) {
-    *result = NULL;
-    return 0;
-  }
-
-  frames_count = cfile.count;
-
   wtap_rec_init(&rec);
   ws_buffer_init(&buf, 1514);
   epan_dissect_init(&edt, cfile.epan, TRUE, FALSE);
 
-  passed_bits = 0;
-  result_bits = (guint8 *) g_malloc(2 + (frames_count / 8));
-
-  for (framenum = 1; framenum <= frames_count; framenum++) {
+  for (framenum = first; framenum <= last; framenum++) {
     frame_data *fdata = sharkd_get_frame(framenum);
 
-    if ((framenum & 7) == 0) {
-      result_bits[(framenum / 8) - 1] = passed_bits;
-      passed_bits = 0;
-    }
+    /* Frames that didn't pass a filter this one refines can't pass it either. */
+    if (candidates && !(candidates[framenum / 8] & (1 << (framenum % 8))))
+      continue;
 
     if (!wtap_seek_read(cfile.provider.wth, fdata->file_off, &rec, &buf, &err, &err_info))
       break;
@@ -738,8 +787,9 @@ sharkd_filter(const char *dftext, guint8 **result)
                      fdata, NULL);
 
     if (dfilter_apply_edt(dfcode, &edt)) {
-      passed_bits |= (1 << (framenum % 8));
+      result_bits[framenum / 8] |= (1 << (framenum % 8));
       prev_dis_num = framenum;
+      passed_count++;
     }
 
     /* if passed or ref -> frame_data_set_after_dissect */
@@ -747,19 +797,200 @@ sharkd_filter(const char *dftext, guint8 **result)
     epan_dissect_reset(&edt);
   }
 
-  if ((framenum & 7) == 0)
-      framenum--;
-  result_bits[framenum / 8] = passed_bits;
-
+  g_free(err_info);
   wtap_rec_cleanup(&rec);
   ws_buffer_free(&buf);
   epan_dissect_cleanup(&edt);
 
+  return passed_count;
+}
+
+#ifndef _WIN32
+static gboolean
+sharkd_filter_write_all(int fd, const void *data, size_t len)
+{
+  const guint8 *p = (const guint8 *) data;
+
+  while (len > 0) {
+    ssize_t n = write(fd, p, len);
+
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      return FALSE;
+    p += n;
+    len -= n;
+  }
+  return TRUE;
+}
+
+static gboolean
+sharkd_filter_read_all(int fd, void *data, size_t len)
+{
+  guint8 *p = (guint8 *) data;
+
+  while (len > 0) {
+    ssize_t n = read(fd, p, len);
+
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      return FALSE;
+    p += n;
+    len -= n;
+  }
+  return TRUE;
+}
+
+/*
+ * epan isn't thread safe, so split the frame range across forked workers
+ * instead. Each child inherits the state of the first pass copy-on-write,
+ * reopens its own random-access handle (the descriptor offset would be
+ * shared with the parent otherwise), filters its slice and writes the
+ * passed count followed by its part of the bitmap back over a pipe.
+ * Ranges a worker failed to deliver are filtered again in the parent.
+ */
+static guint32
+sharkd_filter_parallel(dfilter_t *dfcode, guint32 frames_count, const guint8 *candidates, guint8 *result_bits)
+{
+  guint32 workers = MIN(filter_workers, SHARKD_FILTER_MAX_WORKERS);
+  guint32 chunk = (frames_count + workers - 1) / workers;
+  guint32 passed_count = 0;
+  pid_t pids[SHARKD_FILTER_MAX_WORKERS];
+  int fds[SHARKD_FILTER_MAX_WORKERS];
+  guint32 i;
+
+  /* Don't let the children inherit (and duplicate) buffered output. */
+  fflush(stdout);
+  fflush(stderr);
+
+  for (i = 0; i < workers; i++) {
+    guint32 first = 1 + i * chunk;
+    guint32 last = MIN(frames_count, first + chunk - 1);
+    int pipe_fds[2];
+
+    pids[i] = -1;
+    fds[i] = -1;
+
+    if (first > frames_count)
+      break;
+
+    if (pipe(pipe_fds) < 0)
+      continue;
+
+    pids[i] = fork();
+    if (pids[i] == 0) {
+      guint8 *bits;
+      guint32 passed;
+
+      close(pipe_fds[0]);
+      if (sharkd_reopen_cap_file() != 0)
+        _exit(1);
+
+      bits = (guint8 *) g_malloc0(2 + (frames_count / 8));
+      passed = sharkd_filter_range(dfcode, first, last, candidates, bits);
+
+      if (!sharkd_filter_write_all(pipe_fds[1], &passed, sizeof(passed)) ||
+          !sharkd_filter_write_all(pipe_fds[1], &bits[first / 8], (last / 8) - (first / 8) + 1))
+        _exit(1);
+      _exit(0);
+    }
+
+    close(pipe_fds[1]);
+    if (pids[i] == -1) {
+      close(pipe_fds[0]);
+      continue;
+    }
+    fds[i] = pipe_fds[0];
+  }
+
+  for (i = 0; i < workers; i++) {
+    guint32 first = 1 + i * chunk;
+    guint32 last = MIN(frames_count, first + chunk - 1);
+    gboolean done = FALSE;
+
+    if (first > frames_count)
+      break;
+
+    if (fds[i] != -1) {
+      guint32 nbytes = (last / 8) - (first / 8) + 1;
+      guint8 *bits = (guint8 *) g_malloc(nbytes);
+      guint32 passed;
+
+      if (sharkd_filter_read_all(fds[i], &passed, sizeof(passed)) &&
+          sharkd_filter_read_all(fds[i], bits, nbytes)) {
+        guint32 j;
+
+        /* The first and last byte may be shared with the neighbouring ranges. */
+        for (j = 0; j < nbytes; j++)
+          result_bits[(first / 8) + j] |= bits[j];
+        passed_count += passed;
+        done = TRUE;
+      }
+      g_free(bits);
+      close(fds[i]);
+    }
+
+    if (pids[i] > 0)
+      waitpid(pids[i], NULL, 0);
+
+    if (!done)
+      passed_count += sharkd_filter_range(dfcode, first, last, candidates, result_bits);
+  }
+
+  return passed_count;
+}
+#endif
+
+int
+sharkd_filter(const char *dftext, const guint8 *candidates, guint8 **result)
+{
+  dfilter_t  *dfcode = NULL;
+
+  guint32 frames_count, passed_count;
+  char *err_info = NULL;
+
+  guint8 *result_bits;
+
+  if (!dfilter_compile(dftext, &dfcode, &err_info)) {
+    g_free(err_info);
+    return -1;
+  }
+
+  /* if dfilter_compile() success, but (dfcode == NULL) all frames are matching */
+  if (dfcode == NULL) {
+    *result = NULL;
+    return 0;
+  }
+
+  frames_count = cfile.count;
+
+  result_bits = (guint8 *) g_malloc0(2 + (frames_count / 8));
+
+#ifndef _WIN32
+  if (filter_workers > 1 && frames_count >= SHARKD_FILTER_PARALLEL_MIN_FRAMES)
+    passed_count = sharkd_filter_parallel(dfcode, frames_count, candidates, result_bits);
+  else
+#endif
+    passed_count = sharkd_filter_range(dfcode, 1, frames_count, candidates, result_bits);
+
   dfilter_free(dfcode);
 
+  /* No need to keep a bitmap if every frame matches */
+  if (passed_count == frames_count) {
+    g_free(result_bits);
+    result_bits = NULL;
+  }
+
   *result = result_bits;
 
-  return framenum;
+  return frames_count;
+}
+
+void
+sharkd_set_filter_workers(guint workers)
+{
+  filter_workers = workers;
 }
 
 const char *
@@ -30,8 +30,13 @@ typedef void (*sharkd_dissect_func_t)(epan_dissect_t *edt, proto_tree *tree, str
 /* sharkd.c */
 cf_status_t sharkd_cf_open(const char *fname, unsigned int type, gboolean is_tempfile, int *err);
 int sharkd_load_cap_file(void);
+int sharkd_preload_cap_file(const char *fname);
+gboolean sharkd_is_preloaded(const char *fname);
+void sharkd_forget_preloaded(void);
+int sharkd_reopen_cap_file(void);
 int sharkd_retap(void);
-int sharkd_filter(const char *dftext, guint8 **result);
+int sharkd_filter(const char *dftext, const guint8 *candidates, guint8 **result);
+void sharkd_set_filter_workers(guint workers);
 frame_data *sharkd_get_frame(guint32 framenum);
 int sharkd_dissect_columns(frame_data *fdata, guint32 frame_ref_num, guint32 prev_dis_num, column_info *cinfo, gboolean dissect_color);
 int sharkd_dissect_request(guint32 framenum, guint32 frame_ref_num, guint32 prev_dis_num, sharkd_dissect_func_t cb, guint32 dissect_flags, void *data);
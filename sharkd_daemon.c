@@ -61,6 +61,7 @@
 
 static int mode = 0;
 static socket_handle_t _server_fd = INVALID_SOCKET;
+static char *preload_file = NULL;
 
 static socket_handle_t
 socket_init(char *path)
@@ -192,11 +193,22 @@ print_usage(FILE* output)
 	fprintf(output, "  -v, --version            show version information\n");
 	fprintf(output, "  -C <config profile>, --config-profile <config profile>\n");
 	fprintf(output, "                           start with specified configuration profile\n");
+#ifndef _WIN32
+	fprintf(output, "  -w <count>, --filter-workers <count>\n");
+	fprintf(output, "                           split display filtering of large files across\n");
+	fprintf(output, "                           this many worker processes\n");
+	fprintf(output, "  -l <capture file>, --load <capture file>\n");
+	fprintf(output, "                           load and dissect this file once in the daemon and\n");
+	fprintf(output, "                           share it with every session that loads it\n");
+#endif
 
 	fprintf(output, "\n");
 	fprintf(output, "  Examples:\n");
 	fprintf(output, "    sharkd -C myprofile\n");
 	fprintf(output, "    sharkd -a tcp:127.0.0.1:4446 -C myprofile\n");
+#ifndef _WIN32
+	fprintf(output, "    sharkd -a unix:/tmp/sharkd.sock -l /captures/big.pcapng\n");
+#endif
 
 	fprintf(output, "\n");
 	fprintf(output, "See the sharkd page of the Wireshark wiki for full details.\n");
@@ -226,7 +238,7 @@ sharkd_init(int argc, char **argv)
 	 * platform-dependent.
 	 */
 
-#define OPTSTRING "+" "a:hmvC:"
+#define OPTSTRING "+" "a:hl:mvw:C:"
 
 	static const char    optstring[] = OPTSTRING;
 
@@ -236,10 +248,13 @@ sharkd_init(int argc, char **argv)
 	  {"help", no_argument, NULL, 'h'},
 	  {"version", no_argument, NULL, 'v'},
 	  {"config-profile", required_argument, NULL, 'C'},
+	  {"filter-workers", required_argument, NULL, 'w'},
+	  {"load", required_argument, NULL, 'l'},
 	  {0, 0, 0, 0 }
 	};
 
 	int opt;
+	guint workers;
 
 #ifndef _WIN32
 	pid_t pid;
@@ -325,6 +340,11 @@ sharkd_init(int argc, char **argv)
 				exit(0);
 				break;
 
+			case 'l':        /* Capture file shared by all sessions */
+				g_free(preload_file);
+				preload_file = g_strdup(optarg);
+				break;
+
 			case 'm':
 				// m is an internal-only option used when the daemon session process is created
 				mode = SHARKD_MODE_GOLD_CONSOLE;
@@ -335,6 +355,14 @@ sharkd_init(int argc, char **argv)
 				exit(0);
 				break;
 
+			case 'w':        /* Filter worker processes */
+				if (!ws_strtou32(optarg, NULL, &workers) || workers == 0) {
+					fprintf(stderr, "Invalid number of filter workers \"%s\"\n", optarg);
+					return -1;
+				}
+				sharkd_set_filter_workers(workers);
+				break;
+
 			default:
 				if (!optopt)
 					fprintf(stderr, "This option isn't supported: %s\n", argv[optind]);
@@ -376,6 +404,22 @@ sharkd_loop(int argc _U_, char* argv[])
 		return sharkd_session_main(mode);
 	}
 
+#ifndef _WIN32
+	/* Do the first pass once here; every session forked below inherits it. */
+	if (preload_file)
+	{
+		int err;
+
+		fprintf(stderr, "Sharkd loading: %s\n", preload_file);
+		err = sharkd_preload_cap_file(preload_file);
+		if (err != 0)
+		{
+			fprintf(stderr, "cannot load %s: %s\n", preload_file, err > 0 ? g_strerror(err) : "failed");
+			return -1;
+		}
+	}
+#endif
+
 	while (1)
 	{
 #ifndef _WIN32
@@ -406,6 +450,12 @@ sharkd_loop(int argc _U_, char* argv[])
 			dup2(fd, 1);
 			close(fd);
 
+			if (preload_file && sharkd_reopen_cap_file() != 0)
+			{
+				fprintf(stderr, "cannot reopen %s\n", preload_file);
+				exit(1);
+			}
+
 			exit(sharkd_session_main(mode));
 		}
 
@@ -38,6 +38,7 @@
 #include <ui/io_graph_item.h>
 #include <epan/stats_tree_priv.h>
 #include <epan/stat_tap_ui.h>
+#include <epan/conversation.h>
 #include <epan/conversation_table.h>
 #include <epan/sequence_analysis.h>
 #include <epan/expert.h>
@@ -75,10 +76,90 @@
 struct sharkd_filter_item
 {
 	guint8 *filtered; /* can be NULL if all frames are matching for given filter. */
+	gsize filtered_size; /* size of filtered in bytes */
+	guint64 last_used; /* value of filter_cache.tick when last used, for LRU eviction */
 };
 
 static GHashTable *filter_table = NULL;
 
+/*
+ * Filter results are kept in filter_table until they use more than
+ * SHARKD_FILTER_CACHE_MAX_BYTES, then the least recently used are dropped.
+ */
+#define SHARKD_FILTER_CACHE_MAX_BYTES (256 * 1024 * 1024)
+
+static struct
+{
+	guint64 tick;
+	gsize bytes;
+	guint64 hits;
+	guint64 misses;
+	guint64 refined;
+	guint64 evicted;
+} filter_cache;
+
+/*
+ * Column text of frames already sent by the frames method, per set of
+ * requested columns, so that scrolling back or re-sorting doesn't have
+ * to dissect them again. A row is only reused if it was generated with
+ * the same reference and previously displayed frame. The text is interned
+ * in a string chunk which can't release single strings, so once the
+ * estimated size exceeds SHARKD_COLUMN_CACHE_MAX_BYTES all rows are
+ * flushed at once.
+ */
+#define SHARKD_COLUMN_CACHE_MAX_BYTES (64 * 1024 * 1024)
+
+struct sharkd_column_row
+{
+	guint32 ref_frame;
+	guint32 prev_dis_num;
+	const char **cols; /* interned in column_cache.strings */
+};
+
+struct sharkd_column_set
+{
+	int num_cols;
+	GHashTable *rows; /* frame number -> struct sharkd_column_row */
+};
+
+static struct
+{
+	GHashTable *sets; /* column specification -> struct sharkd_column_set */
+	GStringChunk *strings;
+	gsize bytes;
+	guint rows;
+	guint64 hits;
+	guint64 misses;
+	guint64 flushes;
+} column_cache;
+
+/*
+ * Frames sorted by the frames method, keyed on everything the order depends
+ * on, so paging through a sorted list doesn't sort it again.
+ */
+#define SHARKD_SORT_CACHE_MAX_ENTRIES 8
+
+struct sharkd_sort_entry
+{
+	guint32 framenum;
+	guint32 ref_frame;
+	guint32 prev_dis_num;
+	gboolean num_ok;
+	double num;
+	const char *str; /* interned in strings of the owning sharkd_sort_result */
+};
+
+struct sharkd_sort_result
+{
+	GArray *entries; /* struct sharkd_sort_entry, in sorted order */
+	GStringChunk *strings;
+};
+
+static GHashTable *sort_table = NULL;
+
+/* Frame and byte counts of the loaded file, for graphs that need no dissection. */
+static io_graph_bins_t *iograph_bins = NULL;
+
 static int mode;
 gboolean extended_log = FALSE;
 
@@ -187,10 +268,83 @@ sharkd_session_filter_free(gpointer data)
 {
 	struct sharkd_filter_item *l = (struct sharkd_filter_item *) data;
 
+	filter_cache.bytes -= l->filtered_size;
 	g_free(l->filtered);
 	g_free(l);
 }
 
+/*
+ * Find the most specific (longest) cached filter that "filter" refines.
+ */
+static struct sharkd_filter_item *
+sharkd_session_filter_find_parent(const char *filter)
+{
+	GHashTableIter iter;
+	gpointer key, value;
+	struct sharkd_filter_item *parent = NULL;
+	size_t parent_len = 0;
+
+	g_hash_table_iter_init(&iter, filter_table);
+	while (g_hash_table_iter_next(&iter, &key, &value))
+	{
+		const char *cached = (const char *) key;
+		size_t len = strlen(cached);
+
+		if (len > parent_len && dfilter_text_refines(filter, cached))
+		{
+			parent = (struct sharkd_filter_item *) value;
+			parent_len = len;
+		}
+	}
+
+	return parent;
+}
+
+/*
+ * Drop least recently used filter results until the cache fits in its budget.
+ */
+static void
+sharkd_session_filter_evict(void)
+{
+	while (filter_cache.bytes > SHARKD_FILTER_CACHE_MAX_BYTES)
+	{
+		GHashTableIter iter;
+		gpointer key, value;
+		gpointer oldest_key = NULL;
+		guint64 oldest_used = G_MAXUINT64;
+
+		g_hash_table_iter_init(&iter, filter_table);
+		while (g_hash_table_iter_next(&iter, &key, &value))
+		{
+			struct sharkd_filter_item *l = (struct sharkd_filter_item *) value;
+
+			/* never the one that was just looked up */
+			if (l->filtered_size && l->last_used < oldest_used && l->last_used != filter_cache.tick)
+			{
+				oldest_key = key;
+				oldest_used = l->last_used;
+			}
+		}
+
+		if (!oldest_key)
+			break;
+
+		g_hash_table_remove(filter_table, oldest_key);
+		filter_cache.evicted++;
+	}
+}
+
+/*
+ * Drop all filter results, they are only valid for the frames and
+ * preferences they were computed with.
+ */
+static void
+sharkd_session_filter_flush(void)
+{
+	g_hash_table_remove_all(filter_table);
+	filter_cache.bytes = 0;
+}
+
 static const struct sharkd_filter_item *
 sharkd_session_filter_data(const char *filter)
 {
@@ -200,21 +354,189 @@ sharkd_session_filter_data(const char *filter)
 	if (!l)
 	{
 		guint8 *filtered = NULL;
+		const guint8 *candidates = NULL;
+		struct sharkd_filter_item *parent;
+		int ret;
 
-		int ret = sharkd_filter(filter, &filtered);
+		/* If this narrows down a filter we already have results for,
+		 * only frames which passed that one need to be looked at. */
+		parent = sharkd_session_filter_find_parent(filter);
+		if (parent)
+		{
+			parent->last_used = ++filter_cache.tick;
+			candidates = parent->filtered;
+		}
+
+		ret = sharkd_filter(filter, candidates, &filtered);
 
 		if (ret == -1)
 			return NULL;
 
+		filter_cache.misses++;
+		if (parent)
+			filter_cache.refined++;
+
 		l = g_new(struct sharkd_filter_item, 1);
 		l->filtered = filtered;
+		l->filtered_size = filtered ? 2 + (cfile.count / 8) : 0;
+		filter_cache.bytes += l->filtered_size;
 
 		g_hash_table_insert(filter_table, g_strdup(filter), l);
 	}
+	else
+		filter_cache.hits++;
+
+	l->last_used = ++filter_cache.tick;
+	sharkd_session_filter_evict();
 
 	return l;
 }
 
+static void
+sharkd_session_column_row_free(gpointer data)
+{
+	struct sharkd_column_row *row = (struct sharkd_column_row *) data;
+
+	g_free(row->cols);
+	g_free(row);
+}
+
+static void
+sharkd_session_column_set_free(gpointer data)
+{
+	struct sharkd_column_set *set = (struct sharkd_column_set *) data;
+
+	g_hash_table_destroy(set->rows);
+	g_free(set);
+}
+
+/*
+ * Drop every cached row. The column sets themselves are kept, so pointers
+ * to them stay valid.
+ */
+static void
+sharkd_session_column_cache_flush(void)
+{
+	GHashTableIter iter;
+	gpointer value;
+
+	g_hash_table_iter_init(&iter, column_cache.sets);
+	while (g_hash_table_iter_next(&iter, NULL, &value))
+		g_hash_table_remove_all(((struct sharkd_column_set *) value)->rows);
+
+	g_string_chunk_clear(column_cache.strings);
+	column_cache.bytes = 0;
+	column_cache.rows = 0;
+}
+
+/*
+ * Drop the cached columns of a single frame, e.g. after its comment was
+ * changed.
+ */
+static void
+sharkd_session_column_cache_forget(guint32 framenum)
+{
+	GHashTableIter iter;
+	gpointer value;
+
+	g_hash_table_iter_init(&iter, column_cache.sets);
+	while (g_hash_table_iter_next(&iter, NULL, &value))
+	{
+		if (g_hash_table_remove(((struct sharkd_column_set *) value)->rows, GUINT_TO_POINTER(framenum)))
+			column_cache.rows--;
+	}
+}
+
+static void
+sharkd_session_sort_free(gpointer data)
+{
+	struct sharkd_sort_result *result = (struct sharkd_sort_result *) data;
+
+	g_array_free(result->entries, TRUE);
+	g_string_chunk_free(result->strings);
+	g_free(result);
+}
+
+static struct sharkd_column_set *
+sharkd_session_column_set_get(const char *spec, int num_cols)
+{
+	struct sharkd_column_set *set;
+
+	set = (struct sharkd_column_set *) g_hash_table_lookup(column_cache.sets, spec);
+	if (!set)
+	{
+		set = g_new(struct sharkd_column_set, 1);
+		set->num_cols = num_cols;
+		set->rows = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, sharkd_session_column_row_free);
+		g_hash_table_insert(column_cache.sets, g_strdup(spec), set);
+	}
+	else if (set->num_cols != num_cols)
+	{
+		/* The default columns were changed by a preference. */
+		column_cache.rows -= g_hash_table_size(set->rows);
+		g_hash_table_remove_all(set->rows);
+		set->num_cols = num_cols;
+	}
+
+	return set;
+}
+
+static const struct sharkd_column_row *
+sharkd_session_column_row_get(struct sharkd_column_set *set, guint32 framenum, guint32 ref_frame, guint32 prev_dis_num)
+{
+	struct sharkd_column_row *row;
+
+	row = (struct sharkd_column_row *) g_hash_table_lookup(set->rows, GUINT_TO_POINTER(framenum));
+	if (row && row->ref_frame == ref_frame && row->prev_dis_num == prev_dis_num)
+	{
+		column_cache.hits++;
+		return row;
+	}
+
+	column_cache.misses++;
+	return NULL;
+}
+
+static const struct sharkd_column_row *
+sharkd_session_column_row_add(struct sharkd_column_set *set, guint32 framenum, guint32 ref_frame, guint32 prev_dis_num, const column_info *cinfo)
+{
+	struct sharkd_column_row *row;
+	int col;
+
+	if (column_cache.bytes > SHARKD_COLUMN_CACHE_MAX_BYTES)
+	{
+		sharkd_session_column_cache_flush();
+		column_cache.flushes++;
+	}
+
+	row = g_new(struct sharkd_column_row, 1);
+	row->ref_frame = ref_frame;
+	row->prev_dis_num = prev_dis_num;
+	row->cols = g_new(const char *, set->num_cols);
+	column_cache.bytes += sizeof(*row) + set->num_cols * sizeof(const char *);
+
+	for (col = 0; col < set->num_cols; col++)
+	{
+		const char *text = cinfo->columns[col].col_data;
+
+		if (!text)
+		{
+			row->cols[col] = NULL;
+			continue;
+		}
+
+		/* Counted even if an equal string was interned before, to stay on the safe side. */
+		row->cols[col] = g_string_chunk_insert_const(column_cache.strings, text);
+		column_cache.bytes += strlen(text) + 1;
+	}
+
+	if (g_hash_table_lookup(set->rows, GUINT_TO_POINTER(framenum)) == NULL)
+		column_cache.rows++;
+	g_hash_table_insert(set->rows, GUINT_TO_POINTER(framenum), row);
+
+	return row;
+}
+
 static gboolean
 sharkd_rtp_match_init(rtpstream_id_t *id, const char *init_str)
 {
@@ -548,12 +870,25 @@ sharkd_session_process_load(const char *buf, const jsmntok_t *tokens, int count)
 
 	fprintf(stderr, "load: filename=%s\n", tok_file);
 
+	/* Already loaded by the daemon this session was forked from. */
+	if (sharkd_is_preloaded(tok_file))
+	{
+		sharkd_json_simple_reply(0, NULL);
+		return;
+	}
+
 	if (sharkd_cf_open(tok_file, WTAP_TYPE_AUTO, FALSE, &err) != CF_OK)
 	{
 		sharkd_json_simple_reply(err, NULL);
 		return;
 	}
 
+	sharkd_session_column_cache_flush();
+	g_hash_table_remove_all(sort_table);
+	sharkd_session_filter_flush();
+	io_graph_bins_free(iograph_bins);
+	iograph_bins = NULL;
+
 	TRY
 	{
 		err = sharkd_load_cap_file();
@@ -578,6 +913,22 @@ sharkd_session_process_load(const char *buf, const jsmntok_t *tokens, int count)
  *   (m) duration - time difference between time of first frame, and last loaded frame
  *   (o) filename - capture filename
  *   (o) filesize - capture filesize
+ *   (m) filtercache - display filter result cache statistics:
+ *                  (m) entries - number of cached filter results
+ *                  (m) bytes   - memory used by cached filter results
+ *                  (m) hits    - requests answered from the cache
+ *                  (m) misses  - requests which needed frames to be filtered
+ *                  (m) refined - misses which only filtered the frames passing a cached filter
+ *                  (m) evicted - results dropped to stay within the memory budget
+ *   (m) columncache - frames column text cache statistics:
+ *                  (m) rows    - number of cached rows
+ *                  (m) bytes   - estimated memory used by cached rows
+ *                  (m) hits    - rows sent without dissecting the frame
+ *                  (m) misses  - rows which needed the frame to be dissected
+ *                  (m) flushes - times the cache was emptied to stay within the memory budget
+ *   (m) conversations - conversation tracking statistics:
+ *                  (m) live    - number of conversations currently tracked
+ *                  (m) evicted - conversations freed by the conversation_limit and conversation_idle_timeout preferences
  */
 static void
 sharkd_session_process_status(void)
@@ -603,6 +954,31 @@ sharkd_session_process_status(void)
 			sharkd_json_value_anyf("filesize", "%" G_GINT64_FORMAT, file_size);
 	}
 
+	json_dumper_set_member_name(&dumper, "filtercache");
+	json_dumper_begin_object(&dumper);
+	sharkd_json_value_anyf("entries", "%u", g_hash_table_size(filter_table));
+	sharkd_json_value_anyf("bytes", "%" G_GSIZE_FORMAT, filter_cache.bytes);
+	sharkd_json_value_anyf("hits", "%" G_GUINT64_FORMAT, filter_cache.hits);
+	sharkd_json_value_anyf("misses", "%" G_GUINT64_FORMAT, filter_cache.misses);
+	sharkd_json_value_anyf("refined", "%" G_GUINT64_FORMAT, filter_cache.refined);
+	sharkd_json_value_anyf("evicted", "%" G_GUINT64_FORMAT, filter_cache.evicted);
+	json_dumper_end_object(&dumper);
+
+	json_dumper_set_member_name(&dumper, "columncache");
+	json_dumper_begin_object(&dumper);
+	sharkd_json_value_anyf("rows", "%u", column_cache.rows);
+	sharkd_json_value_anyf("bytes", "%" G_GSIZE_FORMAT, column_cache.bytes);
+	sharkd_json_value_anyf("hits", "%" G_GUINT64_FORMAT, column_cache.hits);
+	sharkd_json_value_anyf("misses", "%" G_GUINT64_FORMAT, column_cache.misses);
+	sharkd_json_value_anyf("flushes", "%" G_GUINT64_FORMAT, column_cache.flushes);
+	json_dumper_end_object(&dumper);
+
+	json_dumper_set_member_name(&dumper, "conversations");
+	json_dumper_begin_object(&dumper);
+	sharkd_json_value_anyf("live", "%u", conversation_count_live());
+	sharkd_json_value_anyf("evicted", "%" G_GUINT64_FORMAT, conversation_count_evicted());
+	json_dumper_end_object(&dumper);
+
 	json_dumper_end_object(&dumper);
 	json_dumper_finish(&dumper);
 }
@@ -763,6 +1139,226 @@ sharkd_session_create_columns(column_info *cinfo, const char *buf, const jsmntok
 	return cinfo;
 }
 
+static void
+sharkd_session_frames_row(struct sharkd_column_set *col_set, column_info *cinfo, guint32 framenum, guint32 ref_frame, guint32 prev_dis_num)
+{
+	frame_data *fdata = sharkd_get_frame(framenum);
+	const struct sharkd_column_row *row;
+	int col;
+
+	row = sharkd_session_column_row_get(col_set, framenum, ref_frame, prev_dis_num);
+	if (!row)
+	{
+		sharkd_dissect_columns(fdata, ref_frame, prev_dis_num, cinfo, (fdata->color_filter == NULL));
+		row = sharkd_session_column_row_add(col_set, framenum, ref_frame, prev_dis_num, cinfo);
+	}
+
+	json_dumper_begin_object(&dumper);
+
+	sharkd_json_array_open("c");
+	for (col = 0; col < col_set->num_cols; ++col)
+		sharkd_json_value_string(NULL, row->cols[col]);
+	sharkd_json_array_close();
+
+	sharkd_json_value_anyf("num", "%u", framenum);
+
+	if (fdata->has_user_comment || fdata->has_phdr_comment)
+	{
+		if (!fdata->has_user_comment || sharkd_get_user_comment(fdata) != NULL)
+			sharkd_json_value_anyf("ct", "true");
+	}
+
+	if (fdata->ignored)
+		sharkd_json_value_anyf("i", "true");
+
+	if (fdata->marked)
+		sharkd_json_value_anyf("m", "true");
+
+	if (fdata->color_filter)
+	{
+		sharkd_json_value_stringf("bg", "%x", color_t_to_rgb(&fdata->color_filter->bg_color));
+		sharkd_json_value_stringf("fg", "%x", color_t_to_rgb(&fdata->color_filter->fg_color));
+	}
+
+	json_dumper_end_object(&dumper);
+}
+
+/*
+ * Same rules as PacketListModel::isNumericColumn(): columns whose text is
+ * compared as a number rather than as a string.
+ */
+static gboolean
+sharkd_session_column_is_numeric(const column_info *cinfo, int col)
+{
+	GSList *l;
+
+	switch (cinfo->columns[col].col_fmt)
+	{
+		case COL_8021Q_VLAN_ID:
+		case COL_CUMULATIVE_BYTES:
+		case COL_DELTA_TIME:
+		case COL_DELTA_TIME_DIS:
+		case COL_UNRES_DST_PORT:
+		case COL_FREQ_CHAN:
+		case COL_RSSI:
+		case COL_TX_RATE:
+		case COL_NUMBER:
+		case COL_PACKET_LENGTH:
+		case COL_UNRES_SRC_PORT:
+		case COL_TEI:
+			return TRUE;
+
+		/* Resolved ports fall back to the string if they don't parse. */
+		case COL_RES_DST_PORT:
+		case COL_DEF_DST_PORT:
+		case COL_DEF_SRC_PORT:
+		case COL_RES_SRC_PORT:
+			return TRUE;
+
+		case COL_CUSTOM:
+			break;
+
+		default:
+			return FALSE;
+	}
+
+	for (l = cinfo->columns[col].col_custom_fields_ids; l; l = l->next)
+	{
+		header_field_info *hfi = proto_registrar_get_nth(*(guint *) l->data);
+
+		if (!hfi ||
+		      (hfi->strings != NULL && !(hfi->display & BASE_UNIT_STRING)) ||
+		      !(((IS_FT_INT(hfi->type) || IS_FT_UINT(hfi->type)) &&
+		         ((FIELD_DISPLAY(hfi->display) == BASE_DEC) ||
+		          (FIELD_DISPLAY(hfi->display) == BASE_OCT) ||
+		          (FIELD_DISPLAY(hfi->display) == BASE_DEC_HEX))) ||
+		        (hfi->type == FT_DOUBLE) || (hfi->type == FT_FLOAT) ||
+		        (hfi->type == FT_BOOLEAN) || (hfi->type == FT_FRAMENUM) ||
+		        (hfi->type == FT_RELATIVE_TIME)))
+			return FALSE;
+	}
+
+	return TRUE;
+}
+
+enum sharkd_sort_type
+{
+	SHARKD_SORT_FRAME_DATA,
+	SHARKD_SORT_NUMERIC,
+	SHARKD_SORT_STRING
+};
+
+struct sharkd_sort_data
+{
+	enum sharkd_sort_type type;
+	int col_fmt;
+	gboolean desc;
+};
+
+/* Mirrors PacketListModel::recordLessThan(), ties are broken by frame number. */
+static gint
+sharkd_session_sort_compare(gconstpointer a, gconstpointer b, gpointer user_data)
+{
+	const struct sharkd_sort_entry *e1 = (const struct sharkd_sort_entry *) a;
+	const struct sharkd_sort_entry *e2 = (const struct sharkd_sort_entry *) b;
+	const struct sharkd_sort_data *data = (const struct sharkd_sort_data *) user_data;
+	gint cmp_val = 0;
+
+	switch (data->type)
+	{
+		case SHARKD_SORT_FRAME_DATA:
+			cmp_val = frame_data_compare(cfile.epan, sharkd_get_frame(e1->framenum), sharkd_get_frame(e2->framenum), data->col_fmt);
+			break;
+
+		case SHARKD_SORT_NUMERIC:
+			if (e1->str == e2->str || (!e1->num_ok && !e2->num_ok))
+				cmp_val = 0;
+			else if (!e1->num_ok || (e2->num_ok && e1->num < e2->num))
+				cmp_val = -1;
+			else if (!e2->num_ok || e1->num > e2->num)
+				cmp_val = 1;
+			break;
+
+		case SHARKD_SORT_STRING:
+			cmp_val = (e1->str == e2->str) ? 0 : strcmp(e1->str, e2->str);
+			break;
+	}
+
+	if (cmp_val == 0)
+		cmp_val = (e1->framenum < e2->framenum) ? -1 : (e1->framenum > e2->framenum);
+
+	return data->desc ? -cmp_val : cmp_val;
+}
+
+/*
+ * Build a typed sort key for every displayed frame once, so comparisons
+ * never have to dissect, then sort and remember the permutation in
+ * sort_table under key, which it takes ownership of along with entries.
+ */
+static const struct sharkd_sort_result *
+sharkd_session_frames_sort(const char *key, GArray *entries, struct sharkd_column_set *col_set, column_info *cinfo, int sort_col, gboolean desc)
+{
+	struct sharkd_sort_result *result;
+	struct sharkd_sort_data data;
+	guint i;
+
+	data.col_fmt = cinfo->columns[sort_col].col_fmt;
+	data.desc = desc;
+	if (col_based_on_frame_data(cinfo, sort_col))
+		data.type = SHARKD_SORT_FRAME_DATA;
+	else if (sharkd_session_column_is_numeric(cinfo, sort_col))
+		data.type = SHARKD_SORT_NUMERIC;
+	else
+		data.type = SHARKD_SORT_STRING;
+
+	result = g_new(struct sharkd_sort_result, 1);
+	result->entries = entries;
+	result->strings = g_string_chunk_new(64 * 1024);
+
+	for (i = 0; i < entries->len; i++)
+	{
+		struct sharkd_sort_entry *entry = &g_array_index(entries, struct sharkd_sort_entry, i);
+		frame_data *fdata = sharkd_get_frame(entry->framenum);
+		const struct sharkd_column_row *row;
+		const char *text;
+
+		if (data.type == SHARKD_SORT_FRAME_DATA)
+		{
+			/* What sharkd_dissect_columns() would set for this row. */
+			fdata->frame_ref_num = entry->ref_frame;
+			fdata->prev_dis_num = entry->prev_dis_num;
+			continue;
+		}
+
+		row = sharkd_session_column_row_get(col_set, entry->framenum, entry->ref_frame, entry->prev_dis_num);
+		if (!row)
+		{
+			sharkd_dissect_columns(fdata, entry->ref_frame, entry->prev_dis_num, cinfo, (fdata->color_filter == NULL));
+			row = sharkd_session_column_row_add(col_set, entry->framenum, entry->ref_frame, entry->prev_dis_num, cinfo);
+		}
+
+		/* The column cache may be flushed while this runs, so keep a copy. */
+		text = row->cols[sort_col] ? row->cols[sort_col] : "";
+		entry->str = g_string_chunk_insert_const(result->strings, text);
+
+		if (data.type == SHARKD_SORT_NUMERIC)
+		{
+			char *end = NULL;
+
+			entry->num = g_ascii_strtod(entry->str, &end);
+			entry->num_ok = (end != entry->str);
+		}
+	}
+
+	g_array_sort_with_data(entries, sharkd_session_sort_compare, &data);
+
+	if (g_hash_table_size(sort_table) >= SHARKD_SORT_CACHE_MAX_ENTRIES)
+		g_hash_table_remove_all(sort_table);
+	g_hash_table_insert(sort_table, g_strdup(key), result);
+
+	return result;
+}
+
 /**
  * sharkd_session_process_frames()
  *
@@ -775,6 +1371,8 @@ sharkd_session_create_columns(column_info *cinfo, const char *buf, const jsmntok
  *   (o) skip=N   - skip N frames
  *   (o) limit=N  - show only N frames
  *   (o) refs  - list (comma separated) with sorted time reference frame numbers.
+ *   (o) sort  - index of the requested column to sort by, skip and limit then apply to the sorted frames
+ *   (o) sortorder - "asc" (default) or "desc"
  *
  * Output array of frames with attributes:
  *   (m) c   - array of column data
@@ -793,6 +1391,8 @@ sharkd_session_process_frames(const char *buf, const jsmntok_t *tokens, int coun
 	const char *tok_skip   = json_find_attr(buf, tokens, count, "skip");
 	const char *tok_limit  = json_find_attr(buf, tokens, count, "limit");
 	const char *tok_refs   = json_find_attr(buf, tokens, count, "refs");
+	const char *tok_sort   = json_find_attr(buf, tokens, count, "sort");
+	const char *tok_sortorder = json_find_attr(buf, tokens, count, "sortorder");
 
 	const guint8 *filter_data = NULL;
 
@@ -805,22 +1405,48 @@ sharkd_session_process_frames(const char *buf, const jsmntok_t *tokens, int coun
 
 	column_info *cinfo = &cfile.cinfo;
 	column_info user_cinfo;
+	struct sharkd_column_set *col_set;
+	GString *spec = g_string_new(NULL);
+
+	guint32 sort_col = 0;
+	gboolean sort_desc = FALSE;
+	char *sort_key = NULL;
+	GArray *sort_entries = NULL;
+	const struct sharkd_sort_result *sorted = NULL;
 
 	if (tok_column)
 	{
+		/* Key the column cache before sharkd_session_create_columns() mangles the tokens. */
+		for (col = 0; col < 32; col++)
+		{
+			char tok_column_name[64];
+
+			snprintf(tok_column_name, sizeof(tok_column_name), "column%d", col);
+			tok_column = json_find_attr(buf, tokens, count, tok_column_name);
+			if (tok_column == NULL)
+				break;
+			g_string_append(spec, tok_column);
+			g_string_append_c(spec, '\n');
+		}
+
 		memset(&user_cinfo, 0, sizeof(user_cinfo));
 		cinfo = sharkd_session_create_columns(&user_cinfo, buf, tokens, count);
 		if (!cinfo)
+		{
+			g_string_free(spec, TRUE);
 			return;
+		}
 	}
 
+	col_set = sharkd_session_column_set_get(spec->str, cinfo->num_cols);
+
 	if (tok_filter)
 	{
 		const struct sharkd_filter_item *filter_item;
 
 		filter_item = sharkd_session_filter_data(tok_filter);
 		if (!filter_item)
-			return;
+			goto done;
 		filter_data = filter_item->filtered;
 	}
 
@@ -828,32 +1454,52 @@ sharkd_session_process_frames(const char *buf, const jsmntok_t *tokens, int coun
 	if (tok_skip)
 	{
 		if (!ws_strtou32(tok_skip, NULL, &skip))
-			return;
+			goto done;
 	}
 
 	limit = 0;
 	if (tok_limit)
 	{
 		if (!ws_strtou32(tok_limit, NULL, &limit))
-			return;
+			goto done;
+	}
+
+	if (tok_sort)
+	{
+		if (!ws_strtou32(tok_sort, NULL, &sort_col) || sort_col >= (guint32) cinfo->num_cols)
+			goto done;
+
+		if (tok_sortorder)
+		{
+			if (!strcmp(tok_sortorder, "desc"))
+				sort_desc = TRUE;
+			else if (strcmp(tok_sortorder, "asc"))
+				goto done;
+		}
+
+		sort_key = g_strdup_printf("%s\n%s\n%s\n%u\n%d", tok_filter ? tok_filter : "", spec->str,
+		                           tok_refs ? tok_refs : "", sort_col, sort_desc);
+		sorted = (const struct sharkd_sort_result *) g_hash_table_lookup(sort_table, sort_key);
+		if (!sorted)
+			sort_entries = g_array_new(FALSE, FALSE, sizeof(struct sharkd_sort_entry));
 	}
 
 	if (tok_refs)
 	{
 		if (!ws_strtou32(tok_refs, &tok_refs, &next_ref_frame))
-			return;
+			goto done;
 	}
 
 	sharkd_json_array_open(NULL);
-	for (framenum = 1; framenum <= cfile.count; framenum++)
+	for (framenum = 1; !sorted && framenum <= cfile.count; framenum++)
 	{
-		frame_data *fdata;
 		guint32 ref_frame = (framenum != 1) ? 1 : 0;
 
 		if (filter_data && !(filter_data[framenum / 8] & (1 << (framenum % 8))))
 			continue;
 
-		if (skip)
+		/* When sorting, the window is only known after every frame was seen. */
+		if (skip && !sort_entries)
 		{
 			skip--;
 			prev_dis_num = framenum;
@@ -891,49 +1537,52 @@ sharkd_session_process_frames(const char *buf, const jsmntok_t *tokens, int coun
 				ref_frame = current_ref_frame;
 		}
 
-		fdata = sharkd_get_frame(framenum);
-		sharkd_dissect_columns(fdata, ref_frame, prev_dis_num, cinfo, (fdata->color_filter == NULL));
-
-		json_dumper_begin_object(&dumper);
-
-		sharkd_json_array_open("c");
-		for (col = 0; col < cinfo->num_cols; ++col)
+		if (sort_entries)
 		{
-			const col_item_t *col_item = &cinfo->columns[col];
+			struct sharkd_sort_entry entry;
 
-			sharkd_json_value_string(NULL, col_item->col_data);
+			memset(&entry, 0, sizeof(entry));
+			entry.framenum = framenum;
+			entry.ref_frame = ref_frame;
+			entry.prev_dis_num = prev_dis_num;
+			g_array_append_val(sort_entries, entry);
+			prev_dis_num = framenum;
+			continue;
 		}
-		sharkd_json_array_close();
 
-		sharkd_json_value_anyf("num", "%u", framenum);
+		sharkd_session_frames_row(col_set, cinfo, framenum, ref_frame, prev_dis_num);
+		prev_dis_num = framenum;
 
-		if (fdata->has_user_comment || fdata->has_phdr_comment)
-		{
-			if (!fdata->has_user_comment || sharkd_get_user_comment(fdata) != NULL)
-				sharkd_json_value_anyf("ct", "true");
-		}
+		if (limit && --limit == 0)
+			break;
+	}
 
-		if (fdata->ignored)
-			sharkd_json_value_anyf("i", "true");
+	if (sort_entries)
+	{
+		sorted = sharkd_session_frames_sort(sort_key, sort_entries, col_set, cinfo, sort_col, sort_desc);
+		sort_entries = NULL;
+	}
 
-		if (fdata->marked)
-			sharkd_json_value_anyf("m", "true");
+	if (sorted)
+	{
+		guint i;
 
-		if (fdata->color_filter)
+		for (i = skip; i < sorted->entries->len; i++)
 		{
-			sharkd_json_value_stringf("bg", "%x", color_t_to_rgb(&fdata->color_filter->bg_color));
-			sharkd_json_value_stringf("fg", "%x", color_t_to_rgb(&fdata->color_filter->fg_color));
-		}
+			const struct sharkd_sort_entry *entry = &g_array_index(sorted->entries, struct sharkd_sort_entry, i);
 
-		json_dumper_end_object(&dumper);
-		prev_dis_num = framenum;
+			sharkd_session_frames_row(col_set, cinfo, entry->framenum, entry->ref_frame, entry->prev_dis_num);
 
-		if (limit && --limit == 0)
-			break;
+			if (limit && --limit == 0)
+				break;
+		}
 	}
 	sharkd_json_array_close();
 	json_dumper_finish(&dumper);
 
+done:
+	g_free(sort_key);
+	g_string_free(spec, TRUE);
 	if (cinfo != &cfile.cinfo)
 		col_cleanup(cinfo);
 }
@@ -2184,7 +2833,7 @@ sharkd_session_process_tap(char *buf, const jsmntok_t *tokens, int count)
 	int i;
 
 	rtpstream_tapinfo_t rtp_tapinfo =
-		{ NULL, NULL, NULL, NULL, 0, NULL, 0, TAP_ANALYSE, NULL, NULL, NULL, FALSE, FALSE};
+		{ NULL, NULL, NULL, NULL, 0, NULL, 0, TAP_ANALYSE, NULL, NULL, NULL, FALSE, FALSE, NULL};
 
 	for (i = 0; i < 16; i++)
 	{
@@ -2933,6 +3582,7 @@ struct sharkd_iograph
 	int num_items;
 	io_graph_item_t *items;
 	GString *error;
+	gboolean tapped; /* FALSE if computed from frame metadata without dissecting */
 };
 
 static tap_packet_status
@@ -2985,6 +3635,7 @@ sharkd_iograph_packet(void *g, packet_info *pinfo, epan_dissect_t *edt, const vo
  *
  * Graph requests can be one of: "packets", "bytes", "bits", "sum:<field>", "frames:<field>", "max:<field>", "min:<field>", "avg:<field>", "load:<field>",
  * if you use variant with <field>, you need to pass field name in filter request.
+ * "packets", "bytes" and "bits" graphs without a filter are computed from frame metadata without dissecting.
  *
  * Output object with attributes:
  *   (m) iograph - array of graph results with attributes:
@@ -3064,16 +3715,31 @@ sharkd_session_process_iograph(char *buf, const jsmntok_t *tokens, int count)
 		graph->num_items = 0;
 		graph->items = NULL;
 
-		if (!graph->error)
+		graph->tapped = FALSE;
+
+		if (!graph->error && graph->calc_type <= IOG_ITEM_UNIT_BITS && (!tok_filter || !*tok_filter))
+		{
+			if (!iograph_bins || iograph_bins->frames_count != cfile.count)
+			{
+				io_graph_bins_free(iograph_bins);
+				iograph_bins = io_graph_bins_new(&cfile);
+			}
+			graph->num_items = io_graph_bins_get_items(iograph_bins, &cfile, interval_ms, SHARKD_IOGRAPH_MAX_ITEMS, &graph->items);
+		}
+		else if (!graph->error)
+		{
 			graph->error = register_tap_listener("frame", graph, tok_filter, TL_REQUIRES_PROTO_TREE, NULL, sharkd_iograph_packet, NULL, NULL);
+			if (graph->error == NULL)
+			{
+				graph->tapped = TRUE;
+				is_any_ok = TRUE;
+			}
+		}
 
 		graph_count++;
-
-		if (graph->error == NULL)
-			is_any_ok = TRUE;
 	}
 
-	/* retap only if we have at least one ok */
+	/* retap only if at least one graph needs dissection */
 	if (is_any_ok)
 		sharkd_retap();
 
@@ -3118,7 +3784,8 @@ sharkd_session_process_iograph(char *buf, const jsmntok_t *tokens, int count)
 		}
 		json_dumper_end_object(&dumper);
 
-		remove_tap_listener(graph);
+		if (graph->tapped)
+			remove_tap_listener(graph);
 		g_free(graph->items);
 	}
 	sharkd_json_array_close();
@@ -3588,6 +4255,8 @@ sharkd_session_process_setcomment(char *buf, const jsmntok_t *tokens, int count)
 		return;
 
 	ret = sharkd_set_user_comment(fdata, tok_comment);
+	/* A column may show the comment. */
+	sharkd_session_column_cache_forget(framenum);
 
 	sharkd_json_simple_reply(ret, NULL);
 }
@@ -3621,6 +4290,15 @@ sharkd_session_process_setconf(char *buf, const jsmntok_t *tokens, int count)
 
 	ret = prefs_set_pref(pref, &errmsg);
 
+	/* Column text, the order of sorted frames and filter results may depend on any preference. */
+	if (ret == PREFS_SET_OK)
+	{
+		sharkd_session_column_cache_flush();
+		g_hash_table_remove_all(sort_table);
+		sharkd_session_filter_flush();
+		sharkd_forget_preloaded();
+	}
+
 	sharkd_json_simple_reply(ret, errmsg);
 	g_free(errmsg);
 }
@@ -4266,6 +4944,9 @@ sharkd_session_main(int mode_setting)
 	dumper.output_file = stdout;
 
 	filter_table = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, sharkd_session_filter_free);
+	column_cache.sets = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, sharkd_session_column_set_free);
+	column_cache.strings = g_string_chunk_new(64 * 1024);
+	sort_table = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, sharkd_session_sort_free);
 
 #ifdef HAVE_MAXMINDDB
 	/* mmdbresolve was stopped before fork(), force starting it */
@@ -4308,6 +4989,9 @@ sharkd_session_main(int mode_setting)
 	}
 
 	g_hash_table_destroy(filter_table);
+	g_hash_table_destroy(column_cache.sets);
+	g_string_chunk_free(column_cache.strings);
+	g_hash_table_destroy(sort_table);
 	g_free(tokens);
 
 	return 0;
@@ -285,6 +285,32 @@ class case_tshark_z_expert(subprocesstest.SubprocessTestCase):
         self.assertFalse(self.grepOutput('Chats'))
 
 
+@fixtures.mark_usefixtures('test_env')
+@fixtures.uses_fixtures
+class case_tshark_z_heur_stat(subprocesstest.SubprocessTestCase):
+    def run_heur_stat(self, cmd_tshark, capture_file, extraArgs=[]):
+        # DTLS on a port without a registered dissector, found by the
+        # dtls_udp heuristic in every frame.
+        proc = self.assertRun([cmd_tshark, '-q', '-z', 'heur,stat',
+            '-r', capture_file('dtls12-aes128ccm8.pcap')] + extraArgs)
+        rows = [line.split() for line in proc.stdout_str.splitlines()]
+        return {row[1]: [int(n) for n in row[2:]] for row in rows
+                if len(row) == 5 and row[0] == 'udp'}
+
+    def test_tshark_z_heur_stat(self, cmd_tshark, capture_file):
+        calls, accepts, conv_hits = self.run_heur_stat(cmd_tshark, capture_file)['dtls_udp']
+        self.assertGreater(accepts, 0)
+        self.assertGreaterEqual(calls, accepts)
+        # Once accepted in the conversation, the heuristic is tried first.
+        self.assertGreater(conv_hits, 0)
+        self.assertLess(conv_hits, accepts)
+
+    def test_tshark_z_heur_stat_2pass(self, cmd_tshark, capture_file):
+        # Only the first pass is counted.
+        self.assertEqual(self.run_heur_stat(cmd_tshark, capture_file, ['-2']),
+            self.run_heur_stat(cmd_tshark, capture_file))
+
+
 @fixtures.mark_usefixtures('test_env')
 @fixtures.uses_fixtures
 class case_tshark_extcap(subprocesstest.SubprocessTestCase):
@@ -44,6 +44,27 @@ class case_decrypt_80211(subprocesstest.SubprocessTestCase):
             ))
         self.assertTrue(self.grepOutput('favicon.ico'))
 
+    def test_80211_wpa_psk_2pass(self, cmd_tshark, capture_file):
+        '''IEEE 802.11 WPA PSK, two passes with and without the decrypted payload cache'''
+        # Both runs must give the same result, including the keys reported
+        # on the second pass, which come from the cache when it is enabled.
+        # Whether the cache was used is not visible in the output.
+        outputs = []
+        for cache_size in ('64', '0'):
+            proc = self.assertRun((cmd_tshark,
+                    '-o', 'wlan.enable_decryption: TRUE',
+                    '-o', 'wlan.decryption_cache_size: ' + cache_size,
+                    '-2',
+                    '-Tfields',
+                    '-e', 'frame.number', '-e', 'wlan.analysis.tk', '-e', 'wlan.analysis.pmk',
+                    '-e', 'http.request.uri',
+                    '-r', capture_file('wpa-Induction.pcap.gz'),
+                    '-Y', 'http',
+                ))
+            self.assertTrue(self.grepOutput('favicon.ico', proc=proc))
+            outputs.append(proc.stdout_str)
+        self.assertEqual(outputs[0], outputs[1])
+
     def test_80211_wpa_eap(self, cmd_tshark, capture_file):
         '''IEEE 802.11 WPA EAP (EAPOL Rekey)'''
         # Included in git sources test/captures/wpa-eap-tls.pcap.gz
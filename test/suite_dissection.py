@@ -114,6 +114,46 @@ class case_dissect_http2(subprocesstest.SubprocessTestCase):
         self.assertFalse(self.grepOutput('00000000  00 00 12 04 00 00 00 00'))
         self.assertTrue(self.grepOutput('00000000  00 00 2c 01 05 00 00 00'))
 
+@fixtures.mark_usefixtures('test_env')
+@fixtures.uses_fixtures
+class case_dissect_netflow(subprocesstest.SubprocessTestCase):
+    def check_ipfix_flows(self, cmd_tshark, capture_file, extraArgs=[]):
+        proc = self.assertRun([cmd_tshark,
+            '-r', capture_file('ipfix-synthetic.pcap'),
+            '-Y', 'cflow.srcaddr',
+            '-Tfields', '-eframe.number', '-ecflow.srcaddr', '-ecflow.if_name',
+            ] + extraArgs)
+        lines = proc.stdout_str.strip().split('\n')
+        self.assertEqual(len(lines), 2)
+        # Fixed length template, four flows.
+        self.assertEqual(lines[0].strip(), '2\t10.0.0.1,10.0.0.2,10.0.0.3,10.0.0.4')
+        # Template with a variable length field, two flows.
+        self.assertEqual(lines[1].strip(), '4\t10.0.2.1,10.0.2.2\teth0,uplink1')
+
+    def test_ipfix_flows(self, cmd_tshark, capture_file):
+        self.check_ipfix_flows(cmd_tshark, capture_file)
+
+    def test_ipfix_flows_2pass(self, cmd_tshark, capture_file):
+        # The display filter makes the first pass build a tree.
+        self.check_ipfix_flows(cmd_tshark, capture_file, extraArgs=['-2'])
+
+    def test_ipfix_sequence_analysis_2pass(self, cmd_tshark, capture_file):
+        # Without a filter the first pass builds no tree and only counts the
+        # flows of fixed length templates, which the sequence analysis of the
+        # following frames depends on.
+        proc = self.assertRun([cmd_tshark,
+            '-r', capture_file('ipfix-synthetic.pcap'), '-2',
+            '-Tfields', '-eframe.number', '-ecflow.sequence', '-ecflow.sequence_analysis.expected_sn',
+            '-ecflow.srcaddr',
+            ])
+        lines = proc.stdout_str.strip().split('\n')
+        self.assertEqual(lines, [
+            '1\t0\t\t',
+            '2\t0\t\t10.0.0.1,10.0.0.2,10.0.0.3,10.0.0.4',
+            '3\t4\t\t',
+            '4\t4\t\t10.0.2.1,10.0.2.2',
+        ])
+
 @fixtures.mark_usefixtures('test_env')
 @fixtures.uses_fixtures
 class case_dissect_protobuf(subprocesstest.SubprocessTestCase):
@@ -337,6 +377,129 @@ class case_dissect_tcp(subprocesstest.SubprocessTestCase):
         self.assertIn('7\t\t', lines[6])
         self.assertNotIn('[TCP segment of a reassembled PDU]', lines[6])
 
+    def test_tcp_out_of_order_many_gaps(self, cmd_tshark, capture_file):
+        '''
+        Test a PDU whose body arrives heavily reordered: after the header,
+        every other segment arrives, then the remaining ones in reverse order
+        and finally the first body segment (40 segments, up to 20 gaps).
+        '''
+        proc = self.assertRun((cmd_tshark,
+            '-r', capture_file('http-ooo-lossy.pcap'),
+            '-otcp.reassemble_out_of_order:TRUE',
+            '-Y', 'http',
+            '-Tfields',
+            '-eframe.number', '-ehttp.content_length', '-e_ws.col.Info',
+            ))
+        lines = proc.stdout_str.strip().split('\n')
+        self.assertEqual(len(lines), 1)
+        self.assertIn('41\t20000\tPUT /lossy HTTP/1.1', lines[0])
+
+    def test_tcp_out_of_order_too_many_gaps(self, cmd_tshark, capture_file):
+        '''
+        Test a PDU with more gaps than are indexed: after the header, the odd
+        ones of 150 body segments arrive, leaving 75 holes, then the even ones
+        in reverse order.
+        '''
+        proc = self.assertRun((cmd_tshark,
+            '-r', capture_file('http-ooo-many-gaps.pcap'),
+            '-otcp.reassemble_out_of_order:TRUE',
+            '-Y', 'http',
+            '-Tfields',
+            '-eframe.number', '-ehttp.content_length', '-e_ws.col.Info',
+            ))
+        lines = proc.stdout_str.strip().split('\n')
+        self.assertEqual(len(lines), 1)
+        self.assertIn('151\t15000\tPUT /gaps HTTP/1.1', lines[0])
+
+    def test_tcp_out_of_order_large_pdu(self, cmd_tshark, capture_file):
+        '''
+        Test a PDU of more than 1 MiB with a hole. The segment that ends its
+        body and starts the next request arrives before the hole is filled,
+        by the last of the 151 frames.
+        '''
+        proc = self.assertRun((cmd_tshark,
+            '-r', capture_file('http-ooo-large.pcap.gz'),
+            '-otcp.reassemble_out_of_order:TRUE',
+            '-Y', 'http',
+            '-Tfields',
+            '-eframe.number', '-ehttp.content_length', '-ehttp.request.method',
+            ))
+        lines = proc.stdout_str.strip().split('\n')
+        self.assertEqual(len(lines), 1)
+        self.assertEqual(lines[0].strip(), '151\t1200000\tPUT,GET')
+
+    def check_tcp_streaming_release(self, cmd_tshark, capture_file, prefs):
+        '''
+        Dissect an HTTP request whose second half follows a 21s pause, during
+        which a second flow is closed, and return the frames with a request.
+        '''
+        args = [cmd_tshark, '-r', capture_file('tcp-streaming-release.pcap')]
+        for pref in prefs:
+            args += ['-o', pref]
+        proc = self.assertRun(args + ['-Tfields', '-eframe.number',
+            '-etcp.analysis.state_bytes', '-ehttp.request.method'])
+        lines = proc.stdout_str.strip().split('\n')
+        self.assertEqual(len(lines), 14)
+        return [line.split('\t') for line in lines]
+
+    def test_tcp_streaming_analysis_off(self, cmd_tshark, capture_file):
+        fields = self.check_tcp_streaming_release(cmd_tshark, capture_file, [])
+        self.assertEqual([f[0] for f in fields if f[2] == 'POST'], ['13'])
+        self.assertEqual([f for f in fields if f[1] != ''], [])
+
+    def test_tcp_streaming_analysis_release(self, cmd_tshark, capture_file):
+        # The SYN of a third flow in frame 12 releases the state of the idle
+        # flow, including the pending first half of its request, and of the
+        # closed flow. The request can no longer be reassembled.
+        fields = self.check_tcp_streaming_release(cmd_tshark, capture_file,
+            ['tcp.streaming_analysis:TRUE', 'tcp.streaming_idle_timeout:10'])
+        self.assertEqual([f[0] for f in fields if f[2] == 'POST'], [])
+        state_bytes = [int(f[1]) for f in fields]
+        # The ACK of the first half sees the pending data, the end of the
+        # request no longer does.
+        self.assertGreater(state_bytes[7], state_bytes[12] + 50)
+
+    def check_tcp_streams_evicted(self, cmd_tshark, capture_file, prefs):
+        '''
+        Dissect three interleaved TCP flows, with a 20s pause before frame
+        16 and before frame 24, and return the TCP stream index of each frame.
+        Frame 21 starts a new session on the ports of the first flow.
+        '''
+        args = [cmd_tshark, '-r', capture_file('tcp-interleaved-flows.pcap')]
+        for pref in prefs:
+            args += ['-o', pref]
+        proc = self.assertRun(args + ['-Tfields', '-etcp.stream', '-etcp.analysis.reused_ports'])
+        lines = proc.stdout_str.strip().split('\n')
+        self.assertEqual(len(lines), 25)
+        # The port reuse is detected whether or not conversations are evicted.
+        self.assertEqual([n + 1 for n, line in enumerate(lines) if line.split('\t')[1:] != ['']], [21])
+        return [int(line.split('\t')[0]) for line in lines]
+
+    def test_tcp_conversation_no_eviction(self, cmd_tshark, capture_file):
+        streams = self.check_tcp_streams_evicted(cmd_tshark, capture_file, [])
+        self.assertEqual(streams,
+            [0, 0, 0, 1, 1, 1, 0, 0, 2, 2, 2, 1, 1, 0, 0,
+             2, 2, 0, 0, 0, 3, 3, 3, 3, 3])
+
+    def test_tcp_conversation_idle_timeout(self, cmd_tshark, capture_file):
+        # After each pause all flows are forgotten and analysis restarts
+        # with a new stream, including both sessions sharing the ports
+        # of the first flow.
+        streams = self.check_tcp_streams_evicted(cmd_tshark, capture_file,
+            ['protocols.conversation_idle_timeout:5'])
+        self.assertEqual(streams,
+            [0, 0, 0, 1, 1, 1, 0, 0, 2, 2, 2, 1, 1, 0, 0,
+             3, 3, 4, 4, 4, 5, 5, 5, 6, 6])
+
+    def test_tcp_conversation_limit(self, cmd_tshark, capture_file):
+        # Only the most recent flow is kept, so every switch between
+        # flows starts a new stream.
+        streams = self.check_tcp_streams_evicted(cmd_tshark, capture_file,
+            ['protocols.conversation_limit:1'])
+        self.assertEqual(streams,
+            [0, 0, 0, 1, 1, 1, 2, 2, 3, 3, 3, 4, 4, 5, 5,
+             6, 6, 7, 7, 7, 8, 8, 8, 8, 8])
+
     def test_tcp_reassembly_more_data_1(self, cmd_tshark, capture_file):
         '''
         Tests that reassembly also works when a new packet begins at the same
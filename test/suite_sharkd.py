@@ -72,7 +72,10 @@ class case_sharkd(subprocesstest.SubprocessTestCase):
         check_sharkd_session((
             {"req": "status"},
         ), (
-            {"frames": 0, "duration": 0.0},
+            {"frames": 0, "duration": 0.0,
+                "filtercache": {"entries": 0, "bytes": 0, "hits": 0, "misses": 0, "refined": 0, "evicted": 0},
+                "columncache": {"rows": 0, "bytes": 0, "hits": 0, "misses": 0, "flushes": 0},
+                "conversations": {"live": MatchAny(int), "evicted": 0}},
         ))
 
     def test_sharkd_req_status(self, check_sharkd_session, capture_file):
@@ -82,7 +85,10 @@ class case_sharkd(subprocesstest.SubprocessTestCase):
         ), (
             {"err": 0},
             {"frames": 4, "duration": 0.070345000,
-                "filename": "dhcp.pcap", "filesize": 1400},
+                "filename": "dhcp.pcap", "filesize": 1400,
+                "filtercache": {"entries": 0, "bytes": 0, "hits": 0, "misses": 0, "refined": 0, "evicted": 0},
+                "columncache": {"rows": 0, "bytes": 0, "hits": 0, "misses": 0, "flushes": 0},
+                "conversations": {"live": MatchAny(int), "evicted": 0}},
         ))
 
     def test_sharkd_req_analyse(self, check_sharkd_session, capture_file):
@@ -169,6 +175,37 @@ class case_sharkd(subprocesstest.SubprocessTestCase):
             }),
         ))
 
+    def test_sharkd_req_frames_cached(self, check_sharkd_session, capture_file):
+        matchFrames = MatchList({
+            "c": MatchList(MatchAny(str)),
+            "num": MatchAny(int),
+            "bg": MatchAny(str),
+            "fg": MatchAny(str),
+        })
+        check_sharkd_session((
+            {"req": "load", "file": capture_file('dhcp.pcap')},
+            {"req": "frames"},
+            {"req": "frames", "skip": 2},
+            {"req": "status"},
+        ), (
+            {"err": 0},
+            matchFrames,
+            MatchList(matchFrames.item, n=2),
+            MatchObject({"columncache": {"rows": 4, "bytes": MatchAny(int), "hits": 2, "misses": 4, "flushes": 0}}),
+        ))
+
+    def test_sharkd_req_frames_sorted(self, check_sharkd_session, capture_file):
+        check_sharkd_session((
+            {"req": "load", "file": capture_file('dhcp.pcap')},
+            {"req": "frames", "sort": 0, "sortorder": "desc", "limit": 2},
+            {"req": "frames", "sort": 0, "sortorder": "desc", "skip": 2},
+            {"req": "frames", "sort": 0, "sortorder": "sideways"},
+        ), (
+            {"err": 0},
+            [MatchObject({"num": 4}), MatchObject({"num": 3})],
+            [MatchObject({"num": 2}), MatchObject({"num": 1})],
+        ))
+
     def test_sharkd_req_tap_invalid(self, check_sharkd_session, capture_file):
         # XXX Unrecognized taps result in an empty line, modify
         #     run_sharkd_session such that checking for it is possible.
@@ -290,6 +327,18 @@ class case_sharkd(subprocesstest.SubprocessTestCase):
                 {"errmsg": 'Filter "garbage filter" is invalid - "filter" was unexpected in this context.'}]},
         ))
 
+    def test_sharkd_req_iograph_metadata(self, check_sharkd_session, capture_file):
+        # Unfiltered packets/bytes graphs skip dissection, they must match the dissected ones.
+        check_sharkd_session((
+            {"req": "load", "file": capture_file('dhcp.pcap')},
+            {"req": "iograph", "interval": 10, "graph0": "packets", "graph1": "packets", "filter1": "frame"},
+            {"req": "iograph", "interval": 7, "graph0": "bits", "graph1": "bits", "filter1": "frame"},
+        ), (
+            {"err": 0},
+            {"iograph": [{"items": [2.000000, "7", 2.000000]}, {"items": [2.000000, "7", 2.000000]}]},
+            {"iograph": [{"items": [5248.000000, "a", 5248.000000]}, {"items": [5248.000000, "a", 5248.000000]}]},
+        ))
+
     def test_sharkd_req_intervals_bad(self, check_sharkd_session, capture_file):
         check_sharkd_session((
             {"req": "load", "file": capture_file('dhcp.pcap')},
@@ -313,6 +362,45 @@ class case_sharkd(subprocesstest.SubprocessTestCase):
             {"intervals": [[0, 2, 656]], "last": 0, "frames": 2, "bytes": 656},
         ))
 
+    def test_sharkd_req_intervals_refined_filter(self, check_sharkd_session, capture_file):
+        check_sharkd_session((
+            {"req": "load", "file": capture_file('dhcp.pcap')},
+            {"req": "intervals", "filter": "frame.number <= 2"},
+            {"req": "intervals", "filter": "frame.number <= 2 && frame.number >= 2"},
+            {"req": "intervals", "filter": "frame.number <= 2"},
+            {"req": "status"},
+        ), (
+            {"err": 0},
+            {"intervals": [[0, 2, 656]], "last": 0, "frames": 2, "bytes": 656},
+            {"intervals": [[0, 1, 328]], "last": 0, "frames": 1, "bytes": 328},
+            {"intervals": [[0, 2, 656]], "last": 0, "frames": 2, "bytes": 656},
+            {"frames": 4, "duration": 0.070345000,
+                "filename": "dhcp.pcap", "filesize": 1400,
+                "filtercache": {"entries": 2, "bytes": 4, "hits": 1, "misses": 2, "refined": 1, "evicted": 0},
+                "columncache": {"rows": 0, "bytes": 0, "hits": 0, "misses": 0, "flushes": 0},
+                "conversations": {"live": MatchAny(int), "evicted": 0}},
+        ))
+
+    def test_sharkd_req_intervals_refined_filter_reload(self, check_sharkd_session, capture_file):
+        # Results for the first file must not be refined for the second one.
+        check_sharkd_session((
+            {"req": "load", "file": capture_file('dhcp.pcap')},
+            {"req": "intervals", "filter": "frame.number >= 3"},
+            {"req": "load", "file": capture_file('http-ooo-lossy.pcap')},
+            {"req": "intervals", "filter": "frame.number >= 3 && tcp"},
+            {"req": "status"},
+        ), (
+            {"err": 0},
+            {"intervals": [[0, 2, 656]], "last": 0, "frames": 2, "bytes": 656},
+            {"err": 0},
+            {"intervals": MatchAny(list), "last": MatchAny(int), "frames": 39, "bytes": MatchAny(int)},
+            {"frames": 41, "duration": MatchAny(float),
+                "filename": "http-ooo-lossy.pcap", "filesize": MatchAny(int),
+                "filtercache": {"entries": 1, "bytes": MatchAny(int), "hits": 0, "misses": 2, "refined": 0, "evicted": 0},
+                "columncache": {"rows": 0, "bytes": 0, "hits": 0, "misses": 0, "flushes": 0},
+                "conversations": {"live": MatchAny(int), "evicted": 0}},
+        ))
+
     def test_sharkd_req_frame_basic(self, check_sharkd_session, capture_file):
         # XXX add more tests for other options (ref_frame, prev_frame, columns, color, bytes, hidden)
         check_sharkd_session((
@@ -360,6 +448,20 @@ class case_sharkd(subprocesstest.SubprocessTestCase):
             {"err": 0, "comment": "foo\nbar", "fol": MatchAny(list)},
         ))
 
+    def test_sharkd_req_setcomment_column(self, check_sharkd_session, capture_file):
+        # The cached columns of the frame must be refreshed.
+        check_sharkd_session((
+            {"req": "load", "file": capture_file('dhcp.pcap')},
+            {"req": "frames", "column0": "frame.comment:0", "limit": 1},
+            {"req": "setcomment", "frame": 1, "comment": "foo"},
+            {"req": "frames", "column0": "frame.comment:0", "limit": 1},
+        ), (
+            {"err": 0},
+            [MatchObject({"num": 1})],
+            {"err": 0},
+            [MatchObject({"c": ["foo"], "num": 1})],
+        ))
+
     def test_sharkd_req_setconf_bad(self, check_sharkd_session):
         check_sharkd_session((
             {"req": "setconf", "name": "uat:garbage-pref", "value": "\"\""},
@@ -0,0 +1,123 @@
+/* tap-heurstat.c
+ * heur,stat   Heuristic dissector call/accept counters
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <glib.h>
+
+#include <epan/packet.h>
+#include <epan/tap.h>
+#include <epan/stat_tap_ui.h>
+
+#include <ui/cmdarg_err.h>
+
+void register_tap_listener_heurstat(void);
+
+static tap_packet_status
+heurstat_packet(void *phs _U_, packet_info *pinfo _U_, epan_dissect_t *edt _U_, const void *dummy _U_)
+{
+	return TAP_PACKET_DONT_REDRAW;
+}
+
+static void
+heurstat_add_entry(const gchar *table_name _U_, heur_dtbl_entry_t *entry, gpointer user_data)
+{
+	GPtrArray *entries = (GPtrArray *)user_data;
+
+	if (entry->calls != 0)
+		g_ptr_array_add(entries, entry);
+}
+
+static void
+heurstat_add_table(const char *table_name, struct heur_dissector_list *table _U_, gpointer user_data)
+{
+	heur_dissector_table_foreach(table_name, heurstat_add_entry, user_data);
+}
+
+static gint
+heurstat_compare(gconstpointer a, gconstpointer b)
+{
+	const heur_dtbl_entry_t *entry_a = *(const heur_dtbl_entry_t * const *)a;
+	const heur_dtbl_entry_t *entry_b = *(const heur_dtbl_entry_t * const *)b;
+
+	if (entry_a->calls != entry_b->calls)
+		return (entry_a->calls < entry_b->calls) ? 1 : -1;
+	return g_strcmp0(entry_a->short_name, entry_b->short_name);
+}
+
+static void
+heurstat_draw(void *phs _U_)
+{
+	GPtrArray *entries = g_ptr_array_new();
+	guint i;
+
+	dissector_all_heur_tables_foreach_table(heurstat_add_table, entries, NULL);
+	g_ptr_array_sort(entries, heurstat_compare);
+
+	printf("\n");
+	printf("===================================================================\n");
+	printf("Heuristic Dissector Statistics:\n");
+	printf("%-16s %-28s %12s %12s %12s\n", "Table", "Heuristic", "Calls", "Accepts", "Conv Hits");
+	for (i = 0; i < entries->len; i++) {
+		const heur_dtbl_entry_t *entry = (const heur_dtbl_entry_t *)g_ptr_array_index(entries, i);
+
+		printf("%-16s %-28s %12" G_GUINT64_FORMAT " %12" G_GUINT64_FORMAT " %12" G_GUINT64_FORMAT "\n",
+			entry->list_name, entry->short_name,
+			entry->calls, entry->accepts, entry->conv_hits);
+	}
+	printf("===================================================================\n");
+
+	g_ptr_array_free(entries, TRUE);
+}
+
+static void
+heurstat_init(const char *opt_arg _U_, void *userdata _U_)
+{
+	GString *error_string;
+
+	error_string = register_tap_listener("frame", NULL, NULL, 0, NULL, heurstat_packet, heurstat_draw, NULL);
+	if (error_string) {
+		cmdarg_err("Couldn't register heur,stat tap: %s",
+			error_string->str);
+		g_string_free(error_string, TRUE);
+		exit(1);
+	}
+}
+
+static stat_tap_ui heurstat_ui = {
+	REGISTER_STAT_GROUP_GENERIC,
+	NULL,
+	"heur,stat",
+	heurstat_init,
+	0,
+	NULL
+};
+
+void
+register_tap_listener_heurstat(void)
+{
+	register_stat_tap_ui(&heurstat_ui, NULL);
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
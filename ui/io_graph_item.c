@@ -14,9 +14,12 @@
 
 
 #include <epan/epan_dissect.h>
+#include <epan/frame_data_sequence.h>
 
 #include "ui/io_graph_item.h"
 
+static const guint32 io_graph_bin_widths[IO_GRAPH_BINS_LEVELS] = { 1, 10, 100, 1000 };
+
 int get_io_graph_index(packet_info *pinfo, int interval) {
     nstime_t time_delta;
 
@@ -263,6 +266,158 @@ double get_io_graph_item(const io_graph_item_t *items_, io_graph_item_unit_t val
     return value;
 }
 
+/*
+ * Milliseconds between the first frame and this one, the same value
+ * get_io_graph_index() derives from pinfo->rel_ts; -1 if it's earlier.
+ */
+static gint64
+io_graph_frame_msec(const frame_data *fdata, const nstime_t *first_ts)
+{
+    nstime_t time_delta;
+
+    nstime_delta(&time_delta, &fdata->abs_ts, first_ts);
+    if (time_delta.nsecs < 0) {
+        time_delta.secs--;
+        time_delta.nsecs += 1000000000;
+    }
+    if (time_delta.secs < 0) {
+        return -1;
+    }
+    return (gint64) time_delta.secs * 1000 + time_delta.nsecs / 1000000;
+}
+
+io_graph_bins_t *io_graph_bins_new(capture_file *cap_file)
+{
+    io_graph_bins_t *bins = g_new0(io_graph_bins_t, 1);
+    gint64 max_msec = 0;
+    guint32 framenum;
+    int level;
+
+    bins->frames_count = cap_file->count;
+    if (cap_file->count == 0) {
+        return bins;
+    }
+
+    bins->first_ts = frame_data_sequence_find(cap_file->provider.frames, 1)->abs_ts;
+
+    for (framenum = 1; framenum <= cap_file->count; framenum++) {
+        gint64 msec = io_graph_frame_msec(frame_data_sequence_find(cap_file->provider.frames, framenum), &bins->first_ts);
+
+        if (msec > max_msec) {
+            max_msec = msec;
+        }
+    }
+
+    for (level = 0; level < IO_GRAPH_BINS_LEVELS; level++) {
+        gint64 num_bins = max_msec / io_graph_bin_widths[level] + 1;
+
+        if (num_bins > IO_GRAPH_BINS_MAX) {
+            continue;
+        }
+        bins->num_bins[level] = (guint32) num_bins;
+        bins->bins[level] = g_new0(io_graph_bin_t, num_bins);
+    }
+
+    for (framenum = 1; framenum <= cap_file->count; framenum++) {
+        const frame_data *fdata = frame_data_sequence_find(cap_file->provider.frames, framenum);
+        gint64 msec = io_graph_frame_msec(fdata, &bins->first_ts);
+
+        if (msec < 0) {
+            continue;
+        }
+
+        for (level = 0; level < IO_GRAPH_BINS_LEVELS; level++) {
+            io_graph_bin_t *bin;
+
+            if (!bins->bins[level]) {
+                continue;
+            }
+            bin = &bins->bins[level][msec / io_graph_bin_widths[level]];
+            bin->frames++;
+            bin->bytes += fdata->pkt_len;
+        }
+    }
+
+    return bins;
+}
+
+void io_graph_bins_free(io_graph_bins_t *bins)
+{
+    int level;
+
+    if (!bins) {
+        return;
+    }
+    for (level = 0; level < IO_GRAPH_BINS_LEVELS; level++) {
+        g_free(bins->bins[level]);
+    }
+    g_free(bins);
+}
+
+static void
+io_graph_bins_add(io_graph_item_t **items_p, int *space_items, int *num_items, int idx, guint32 frames, guint64 bytes)
+{
+    if (idx >= *space_items) {
+        int new_size = idx + 1024;
+
+        *items_p = (io_graph_item_t *) g_realloc(*items_p, sizeof(io_graph_item_t) * new_size);
+        reset_io_graph_items(&(*items_p)[*space_items], new_size - *space_items);
+        *space_items = new_size;
+    }
+    (*items_p)[idx].frames += frames;
+    (*items_p)[idx].bytes += bytes;
+    if (idx + 1 > *num_items) {
+        *num_items = idx + 1;
+    }
+}
+
+int io_graph_bins_get_items(const io_graph_bins_t *bins, capture_file *cap_file, guint32 interval, int max_items, io_graph_item_t **items_p)
+{
+    int space_items = 0;
+    int num_items = 0;
+    int level;
+
+    *items_p = NULL;
+
+    /* The coarsest level the interval is a multiple of has the fewest bins to add up. */
+    for (level = IO_GRAPH_BINS_LEVELS - 1; level >= 0; level--) {
+        if (bins->bins[level] && interval % io_graph_bin_widths[level] == 0) {
+            break;
+        }
+    }
+
+    if (level >= 0) {
+        guint32 per_item = interval / io_graph_bin_widths[level];
+        guint32 b;
+
+        for (b = 0; b < bins->num_bins[level]; b++) {
+            const io_graph_bin_t *bin = &bins->bins[level][b];
+            guint32 idx = b / per_item;
+
+            if (idx >= (guint32) max_items) {
+                break;
+            }
+            if (bin->frames) {
+                io_graph_bins_add(items_p, &space_items, &num_items, (int) idx, bin->frames, bin->bytes);
+            }
+        }
+    } else {
+        guint32 framenum;
+
+        for (framenum = 1; framenum <= bins->frames_count; framenum++) {
+            const frame_data *fdata = frame_data_sequence_find(cap_file->provider.frames, framenum);
+            gint64 msec = io_graph_frame_msec(fdata, &bins->first_ts);
+
+            if (msec < 0 || msec / interval >= max_items) {
+                continue;
+            }
+            io_graph_bins_add(items_p, &space_items, &num_items, (int) (msec / interval), 1, fdata->pkt_len);
+        }
+    }
+
+    return num_items;
+}
+
 /*
  * Editor modelines
  *
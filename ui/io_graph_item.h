@@ -395,6 +395,52 @@ update_io_graph_item(io_graph_item_t *items, int idx, packet_info *pinfo, epan_d
 }
 
 
+/*
+ * Frame and byte counts per interval computed from the frame metadata
+ * (timestamp and length) alone, for graphs which need neither a display
+ * filter nor a field and so don't have to dissect anything. Counts are
+ * kept at a few fixed resolutions, so an interval which is a multiple of
+ * one of them is answered by adding up bins instead of looking at every
+ * frame again; other intervals fall back to a scan of the frame metadata.
+ */
+#define IO_GRAPH_BINS_LEVELS 4          /* 1 ms, 10 ms, 100 ms and 1 s */
+#define IO_GRAPH_BINS_MAX    (1 << 20)  /* per level; finer levels are skipped for long captures */
+
+typedef struct _io_graph_bin_t {
+    guint32  frames;
+    guint64  bytes;
+} io_graph_bin_t;
+
+typedef struct _io_graph_bins_t {
+    guint32         frames_count;   /* number of frames the bins were built from */
+    nstime_t        first_ts;       /* time of the first frame; bins are relative to it */
+    guint32         num_bins[IO_GRAPH_BINS_LEVELS];
+    io_graph_bin_t *bins[IO_GRAPH_BINS_LEVELS];  /* NULL if the level would be too large */
+} io_graph_bins_t;
+
+/** Build the bins for all frames of a capture file.
+ * @param cap_file [in] Capture file, after the first pass.
+ * @return The bins, to be freed with io_graph_bins_free().
+ */
+io_graph_bins_t *io_graph_bins_new(capture_file *cap_file);
+
+/** Free bins built by io_graph_bins_new().
+ * @param bins [in] The bins to free. May be NULL.
+ */
+void io_graph_bins_free(io_graph_bins_t *bins);
+
+/** Get frame and byte counts for an interval without dissecting.
+ * Only the frames and bytes members of the items are filled in, which is
+ * all get_io_graph_item() needs for IOG_ITEM_UNIT_PACKETS, _BYTES and _BITS.
+ * @param bins [in] Bins of the capture file.
+ * @param cap_file [in] Capture file the bins were built from.
+ * @param interval [in] Timing interval in ms.
+ * @param max_items [in] Intervals at or beyond this index are ignored.
+ * @param items_p [out] Newly allocated array of items, to be freed with g_free().
+ * @return The number of items, that is the index of the last non-empty interval plus one.
+ */
+int io_graph_bins_get_items(const io_graph_bins_t *bins, capture_file *cap_file, guint32 interval, int max_items, io_graph_item_t **items_p);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
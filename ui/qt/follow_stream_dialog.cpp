@@ -68,7 +68,8 @@ FollowStreamDialog::FollowStreamDialog(QWidget &parent, CaptureFile &cf, follow_
     follow_type_(type),
     follower_(NULL),
     show_type_(SHOW_ASCII),
-    truncated_(false),
+    window_first_(0),
+    window_last_(0),
     client_buffer_count_(0),
     server_buffer_count_(0),
     client_packet_count_(0),
@@ -148,6 +149,8 @@ FollowStreamDialog::FollowStreamDialog(QWidget &parent, CaptureFile &cf, follow_
             this, SLOT(fillHintLabel(int)));
     connect(ui->teStreamContent, SIGNAL(mouseClickedOnTextCursorPosition(int)),
             this, SLOT(goToPacketForTextPos(int)));
+    connect(ui->teStreamContent->verticalScrollBar(), SIGNAL(valueChanged(int)),
+            this, SLOT(scrollWindow(int)));
 
     fillHintLabel(-1);
 }
@@ -208,6 +211,13 @@ void FollowStreamDialog::fillHintLabel(int text_pos)
             .arg(ColorUtils::fromColorT(prefs.st_server_bg).name())
             + tr("%Ln turn(s).", "", turns_);
 
+    if (window_first_ > 0 || window_last_ < chunks_.size()) {
+        hint += " " + tr("Showing segments %1 to %2 of %3.")
+                .arg(window_first_ + 1)
+                .arg(window_last_)
+                .arg(chunks_.size());
+    }
+
     if (pkt > 0) {
         hint.append(QString(tr(" Click to select.")));
     }
@@ -269,17 +279,48 @@ void FollowStreamDialog::findText(bool go_back)
 {
     if (ui->leFind->text().isEmpty()) return;
 
+    QRegExp regex(ui->leFind->text());
     bool found;
     if (use_regex_find_) {
-        QRegExp regex(ui->leFind->text());
         found = ui->teStreamContent->find(regex);
     } else {
         found = ui->teStreamContent->find(ui->leFind->text());
     }
 
+    // Not in the rendered window. Search the text of the chunks after it
+    // one at a time and move the window to the first one that matches.
+    QElapsedTimer elapsed_timer;
+    elapsed_timer.start();
+    for (int chunk = window_last_; !found && chunk < chunks_.size(); chunk++) {
+        QString text = chunkText(chunks_[chunk]);
+        bool chunk_match;
+        if (use_regex_find_) {
+            chunk_match = text.contains(regex);
+        } else {
+            chunk_match = text.contains(ui->leFind->text(), Qt::CaseInsensitive);
+        }
+        if (chunk_match) {
+            renderWindow(chunk);
+            ui->teStreamContent->moveCursor(QTextCursor::Start);
+            if (use_regex_find_) {
+                found = ui->teStreamContent->find(regex);
+            } else {
+                found = ui->teStreamContent->find(ui->leFind->text());
+            }
+        }
+        if (elapsed_timer.elapsed() > info_update_freq_) {
+            wsApp->processEvents();
+            if (dialogClosed()) return;
+            elapsed_timer.start();
+        }
+    }
+
     if (found) {
         ui->teStreamContent->setFocus();
     } else if (go_back) {
+        if (window_first_ > 0) {
+            renderWindow(0);
+        }
         ui->teStreamContent->moveCursor(QTextCursor::Start);
         findText(false);
     }
@@ -298,16 +339,18 @@ void FollowStreamDialog::saveAs()
         return;
     }
 
-    // Unconditionally save data as UTF-8 (even if data is decoded otherwise).
-    QByteArray bytes = ui->teStreamContent->toPlainText().toUtf8();
-    if (show_type_ == SHOW_RAW) {
-        // The "Raw" format is currently displayed as hex data and needs to be
-        // converted to binary data.
-        bytes = QByteArray::fromHex(bytes);
-    }
-
+    // Save every chunk, not just the rendered window.
     QDataStream out(&file);
-    out.writeRawData(bytes.constData(), bytes.size());
+    foreach (const FollowChunk &chunk, chunks_) {
+        // Unconditionally save data as UTF-8 (even if data is decoded otherwise).
+        QByteArray bytes = chunkText(chunk).toUtf8();
+        if (show_type_ == SHOW_RAW) {
+            // The "Raw" format is currently displayed as hex data and needs to be
+            // converted to binary data.
+            bytes = QByteArray::fromHex(bytes);
+        }
+        out.writeRawData(bytes.constData(), bytes.size());
+    }
 }
 
 void FollowStreamDialog::helpButton()
@@ -466,6 +509,9 @@ void FollowStreamDialog::resetStream()
 
     filter_out_filter_.clear();
     text_pos_to_packet_.clear();
+    chunks_.clear();
+    window_chunk_pos_.clear();
+    window_first_ = window_last_ = 0;
     if (!data_out_filename_.isEmpty()) {
         ws_unlink(data_out_filename_.toUtf8().constData());
     }
@@ -508,8 +554,10 @@ FollowStreamDialog::readStream()
 
     ui->teStreamContent->clear();
     text_pos_to_packet_.clear();
+    chunks_.clear();
+    window_chunk_pos_.clear();
+    window_first_ = window_last_ = 0;
 
-    truncated_ = false;
     frs_return_t ret;
 
     client_buffer_count_ = 0;
@@ -548,19 +596,8 @@ FollowStreamDialog::followStream()
     readStream();
 }
 
-const int FollowStreamDialog::max_document_length_ = 500 * 1000 * 1000; // Just a guess
 void FollowStreamDialog::addText(QString text, gboolean is_from_server, guint32 packet_num)
 {
-    if (truncated_) {
-        return;
-    }
-
-    int char_count = ui->teStreamContent->document()->characterCount();
-    if (char_count + text.length() > max_document_length_) {
-        text.truncate(max_document_length_ - char_count);
-        truncated_ = true;
-    }
-
     setUpdatesEnabled(false);
     int cur_pos = ui->teStreamContent->verticalScrollBar()->value();
     ui->teStreamContent->moveCursor(QTextCursor::End);
@@ -577,16 +614,68 @@ void FollowStreamDialog::addText(QString text, gboolean is_from_server, guint32
     ui->teStreamContent->insertPlainText(text);
     text_pos_to_packet_[ui->teStreamContent->textCursor().anchor()] = packet_num;
 
-    if (truncated_) {
-        tcf = ui->teStreamContent->currentCharFormat();
-        tcf.setBackground(palette().window().color());
-        tcf.setForeground(palette().windowText().color());
-        ui->teStreamContent->insertPlainText("\n" + tr("[Stream output truncated]"));
-        ui->teStreamContent->moveCursor(QTextCursor::End);
+    ui->teStreamContent->verticalScrollBar()->setValue(cur_pos);
+    setUpdatesEnabled(true);
+}
+
+// Only a window of roughly this many characters is kept in teStreamContent.
+// The rest of the stream is rendered from follow_info_.payload as the user
+// scrolls or searches.
+const int FollowStreamDialog::window_chars_ = 2 * 1000 * 1000;
+
+// Replace the contents of teStreamContent with the chunks starting at
+// first_chunk.
+void FollowStreamDialog::renderWindow(int first_chunk)
+{
+    QScrollBar *vsb = ui->teStreamContent->verticalScrollBar();
+    bool blocked = vsb->blockSignals(true);
+
+    ui->teStreamContent->clear();
+    text_pos_to_packet_.clear();
+    window_chunk_pos_.clear();
+
+    int char_count = 0;
+    int chunk = first_chunk;
+    for (; chunk < chunks_.size() && (chunk == first_chunk || char_count < window_chars_); chunk++) {
+        QString text = chunkText(chunks_[chunk]);
+        window_chunk_pos_ << ui->teStreamContent->textCursor().position();
+        addText(text, chunks_[chunk].record->is_server, chunks_[chunk].record->packet_num);
+        char_count += text.length();
+    }
+    window_first_ = first_chunk;
+    window_last_ = chunk;
+
+    vsb->blockSignals(blocked);
+}
+
+// Slide the window by half its size when the user scrolls to either end.
+void FollowStreamDialog::scrollWindow(int value)
+{
+    QScrollBar *vsb = ui->teStreamContent->verticalScrollBar();
+    int anchor_chunk;
+
+    if (value >= vsb->maximum() && window_last_ < chunks_.size()) {
+        anchor_chunk = window_last_;
+        renderWindow(qMax(window_first_ + 1, (window_first_ + window_last_) / 2));
+    } else if (value <= vsb->minimum() && window_first_ > 0) {
+        anchor_chunk = window_first_;
+        renderWindow(qMax(0, window_first_ - qMax(1, (window_last_ - window_first_) / 2)));
     } else {
-        ui->teStreamContent->verticalScrollBar()->setValue(cur_pos);
+        return;
     }
-    setUpdatesEnabled(true);
+
+    // Keep the text the user was looking at in view.
+    QTextCursor cursor = ui->teStreamContent->textCursor();
+    if (anchor_chunk < window_last_) {
+        cursor.setPosition(window_chunk_pos_.at(anchor_chunk - window_first_));
+    } else {
+        cursor.movePosition(QTextCursor::End);
+    }
+    bool blocked = vsb->blockSignals(true);
+    ui->teStreamContent->setTextCursor(cursor);
+    ui->teStreamContent->centerCursor();
+    vsb->blockSignals(blocked);
+    fillHintLabel(-1);
 }
 
 // The following keyboard shortcuts should work (although
@@ -647,13 +736,20 @@ static inline void sanitize_buffer(char *buffer, size_t nchars) {
     }
 }
 
-frs_return_t
-FollowStreamDialog::showBuffer(char *buffer, size_t nchars, gboolean is_from_server, guint32 packet_num,
-                                guint32 *global_pos)
+QString FollowStreamDialog::chunkText(const FollowChunk &chunk)
 {
     gchar initbuf[256];
     guint32 current_pos;
     static const gchar hexchars[16] = {'0','1','2','3','4','5','6','7','8','9','a','b','c','d','e','f'};
+    QString text;
+
+    // We want a deep copy.
+    QByteArray chunk_buffer((const char *) chunk.record->data->data, chunk.record->data->len);
+    char *buffer = chunk_buffer.data();
+    size_t nchars = chunk.record->data->len;
+    gboolean is_from_server = chunk.record->is_server;
+    guint32 packet_num = chunk.record->packet_num;
+    guint32 global_pos = chunk.global_pos;
 
     switch (show_type_) {
 
@@ -663,7 +759,7 @@ FollowStreamDialog::showBuffer(char *buffer, size_t nchars, gboolean is_from_ser
         EBCDIC_to_ASCII((guint8*)buffer, (guint) nchars);
         sanitize_buffer(buffer, nchars);
         QByteArray ba = QByteArray(buffer, (int)nchars);
-        addText(ba, is_from_server, packet_num);
+        text += ba;
         break;
     }
 
@@ -674,7 +770,7 @@ FollowStreamDialog::showBuffer(char *buffer, size_t nchars, gboolean is_from_ser
          */
         sanitize_buffer(buffer, nchars);
         QByteArray ba = QByteArray(buffer, (int)nchars);
-        addText(ba, is_from_server, packet_num);
+        text += ba;
         break;
     }
 
@@ -688,7 +784,7 @@ FollowStreamDialog::showBuffer(char *buffer, size_t nchars, gboolean is_from_ser
         QTextCodec *codec = QTextCodec::codecForName(ui->cbCharset->currentText().toUtf8());
         QByteArray ba = QByteArray(buffer, (int)nchars);
         QString decoded = codec->toUnicode(ba);
-        addText(decoded, is_from_server, packet_num);
+        text += decoded;
         break;
     }
 
@@ -706,7 +802,7 @@ FollowStreamDialog::showBuffer(char *buffer, size_t nchars, gboolean is_from_ser
                 memset(cur, ' ', 4);
                 cur += 4;
             }
-            cur += g_snprintf(cur, 20, "%08X  ", *global_pos);
+            cur += g_snprintf(cur, 20, "%08X  ", global_pos);
             /* 49 is space consumed by hex chars */
             ascii_start = cur + 49 + 2;
             for (i = 0; i < 16 && current_pos + i < nchars; i++) {
@@ -732,11 +828,11 @@ FollowStreamDialog::showBuffer(char *buffer, size_t nchars, gboolean is_from_ser
                 }
             }
             current_pos += i;
-            (*global_pos) += i;
+            global_pos += i;
             *cur++ = '\n';
             *cur = 0;
 
-            addText(hexbuf, is_from_server, packet_num);
+            text += hexbuf;
         }
         break;
 
@@ -744,9 +840,9 @@ FollowStreamDialog::showBuffer(char *buffer, size_t nchars, gboolean is_from_ser
         current_pos = 0;
         g_snprintf(initbuf, sizeof(initbuf), "char peer%d_%d[] = { /* Packet %u */\n",
                    is_from_server ? 1 : 0,
-                   is_from_server ? server_buffer_count_++ : client_buffer_count_++,
+                   chunk.buffer_num,
                    packet_num);
-        addText(initbuf, is_from_server, packet_num);
+        text += initbuf;
 
         while (current_pos < nchars) {
             gchar hexbuf[256];
@@ -776,10 +872,10 @@ FollowStreamDialog::showBuffer(char *buffer, size_t nchars, gboolean is_from_ser
             }
 
             current_pos += i;
-            (*global_pos) += i;
+            global_pos += i;
             hexbuf[cur++] = '\n';
             hexbuf[cur] = 0;
-            addText(hexbuf, is_from_server, packet_num);
+            text += hexbuf;
         }
         break;
 
@@ -790,11 +886,11 @@ FollowStreamDialog::showBuffer(char *buffer, size_t nchars, gboolean is_from_ser
         const int base64_raw_len = 57; // Encodes to 76 bytes, common in RFCs
         current_pos = 0;
 
-        if (packet_num != last_packet_) {
+        if (chunk.buffer_num >= 0) {
             yaml_text.append(QString("# Packet %1\npeer%2_%3: !!binary |\n")
                     .arg(packet_num)
                     .arg(is_from_server ? 1 : 0)
-                    .arg(is_from_server ? server_buffer_count_++ : client_buffer_count_++));
+                    .arg(chunk.buffer_num));
         }
         while (current_pos < nchars) {
             int len = current_pos + base64_raw_len < nchars ? base64_raw_len : (int) nchars - current_pos;
@@ -803,9 +899,9 @@ FollowStreamDialog::showBuffer(char *buffer, size_t nchars, gboolean is_from_ser
             yaml_text += "  " + base64_data.toBase64() + "\n";
 
             current_pos += len;
-            (*global_pos) += len;
+            global_pos += len;
         }
-        addText(yaml_text, is_from_server, packet_num);
+        text += yaml_text;
         break;
     }
 
@@ -813,29 +909,12 @@ FollowStreamDialog::showBuffer(char *buffer, size_t nchars, gboolean is_from_ser
     {
         QByteArray ba = QByteArray(buffer, (int)nchars).toHex();
         ba += '\n';
-        addText(ba, is_from_server, packet_num);
+        text += ba;
         break;
     }
     }
 
-    if (last_packet_ == 0) {
-        last_from_server_ = is_from_server;
-    }
-
-    if (packet_num != last_packet_) {
-        last_packet_ = packet_num;
-        if (is_from_server) {
-            server_packet_count_++;
-        } else {
-            client_packet_count_++;
-        }
-        if (last_from_server_ != is_from_server) {
-            last_from_server_ = is_from_server;
-            turns_++;
-        }
-    }
-
-    return FRS_OK;
+    return text;
 }
 
 bool FollowStreamDialog::follow(QString previous_filter, bool use_stream_index, guint stream_num, guint sub_stream_num)
@@ -1108,15 +1187,11 @@ FollowStreamDialog::readFollowStream()
     guint32 *global_pos;
     gboolean skip;
     GList* cur;
-    frs_return_t frs_return;
     follow_record_t *follow_record;
-    QElapsedTimer elapsed_timer;
-
-    elapsed_timer.start();
 
+    // Index the records in the direction(s) we're showing. Text is only
+    // rendered for the window that's displayed.
     for (cur = g_list_last(follow_info_.payload); cur; cur = g_list_previous(cur)) {
-        if (dialogClosed()) break;
-
         follow_record = (follow_record_t *)cur->data;
         skip = FALSE;
         if (!follow_record->is_server) {
@@ -1130,28 +1205,42 @@ FollowStreamDialog::readFollowStream()
                 skip = TRUE;
             }
         }
+        if (skip) {
+            continue;
+        }
+
+        gboolean is_from_server = follow_record->is_server;
+        guint32 packet_num = follow_record->packet_num;
+        FollowChunk chunk;
+
+        chunk.record = follow_record;
+        chunk.global_pos = *global_pos;
+        chunk.buffer_num = -1;
+        if (show_type_ == SHOW_CARRAY || (show_type_ == SHOW_YAML && packet_num != last_packet_)) {
+            chunk.buffer_num = is_from_server ? server_buffer_count_++ : client_buffer_count_++;
+        }
+        chunks_ << chunk;
+        (*global_pos) += follow_record->data->len;
+
+        if (last_packet_ == 0) {
+            last_from_server_ = is_from_server;
+        }
 
-        QByteArray buffer;
-        if (!skip) {
-            // We want a deep copy.
-            buffer.clear();
-            buffer.append((const char *) follow_record->data->data,
-                                     follow_record->data->len);
-            frs_return = showBuffer(
-                        buffer.data(),
-                        follow_record->data->len,
-                        follow_record->is_server,
-                        follow_record->packet_num,
-                        global_pos);
-            if (frs_return == FRS_PRINT_ERROR)
-                return frs_return;
-            if (elapsed_timer.elapsed() > info_update_freq_) {
-                fillHintLabel(ui->teStreamContent->textCursor().position());
-                wsApp->processEvents();
-                elapsed_timer.start();
+        if (packet_num != last_packet_) {
+            last_packet_ = packet_num;
+            if (is_from_server) {
+                server_packet_count_++;
+            } else {
+                client_packet_count_++;
+            }
+            if (last_from_server_ != is_from_server) {
+                last_from_server_ = is_from_server;
+                turns_++;
             }
         }
     }
 
+    renderWindow(0);
+
     return FRS_OK;
 }
@@ -29,6 +29,7 @@
 #include <QFile>
 #include <QMap>
 #include <QPushButton>
+#include <QVector>
 
 namespace Ui {
 class FollowStreamDialog;
@@ -66,6 +67,7 @@ private slots:
     void printStream();
     void fillHintLabel(int text_pos);
     void goToPacketForTextPos(int text_pos);
+    void scrollWindow(int value);
 
     void on_streamNumberSpinBox_valueChanged(int stream_num);
     void on_subStreamNumberSpinBox_valueChanged(int sub_stream_num);
@@ -81,9 +83,16 @@ private:
     void resetStream(void);
     void updateWidgets(bool follow_in_progress);
     void updateWidgets() { updateWidgets(false); } // Needed for WiresharkDialog?
-    frs_return_t
-    showBuffer(char *buffer, size_t nchars, gboolean is_from_server,
-                guint32 packet_num, guint32 *global_pos);
+    // One entry per payload record shown in the current direction, in
+    // stream order. Text is rendered from the record on demand.
+    struct FollowChunk {
+        follow_record_t *record;
+        guint32 global_pos;     // Offset of the first byte in its direction.
+        int buffer_num;         // C array / YAML buffer number, -1 for none.
+    };
+
+    QString chunkText(const FollowChunk &chunk);
+    void renderWindow(int first_chunk);
 
     frs_return_t readStream();
     frs_return_t readFollowStream();
@@ -105,8 +114,11 @@ private:
     register_follow_t*      follower_;
     show_type_t             show_type_;
     QString                 data_out_filename_;
-    static const int        max_document_length_;
-    bool                    truncated_;
+    static const int        window_chars_;
+    QVector<FollowChunk>    chunks_;
+    int                     window_first_;
+    int                     window_last_;
+    QVector<int>            window_chunk_pos_;
     QString                 previous_filter_;
     QString                 filter_out_filter_;
     QString                 output_filter_;
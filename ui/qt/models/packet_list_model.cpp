@@ -8,6 +8,8 @@
  */
 
 #include <algorithm>
+#include <functional>
+#include <vector>
 #include <glib.h>
 
 #include "packet_list_model.h"
@@ -36,6 +38,9 @@
 #include <QFontMetrics>
 #include <QModelIndex>
 #include <QElapsedTimer>
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
 
 // Print timing information
 //#define DEBUG_PACKET_LIST_MODEL 1
@@ -164,6 +169,7 @@ guint PacketListModel::recreateVisibleRows()
 void PacketListModel::clear() {
     emit beginResetModel();
     qDeleteAll(physical_rows_);
+    PacketListRecord::clearTextCache();
     physical_rows_.resize(0);
     visible_rows_.resize(0);
     new_visible_rows_.resize(0);
@@ -342,6 +348,25 @@ capture_file *PacketListModel::sort_cap_file_;
 
 QElapsedTimer busy_timer_;
 const int busy_timeout_ = 65; // ms, approximately 15 fps
+
+// Text columns with at least this many records are sorted on multiple threads.
+static const int parallel_sort_min_rows_ = 50000;
+
+// Sorts or merges part of the sort key array on a pool thread.
+class SortKeyRunnable : public QRunnable
+{
+public:
+    SortKeyRunnable(std::function<void()> func) : func_(func) {}
+
+private:
+    void run()
+    {
+        func_();
+    }
+
+    std::function<void()> func_;
+};
+
 void PacketListModel::sort(int column, Qt::SortOrder order)
 {
     if (!cap_file_ || visible_rows_.count() < 1) return;
@@ -354,8 +379,8 @@ void PacketListModel::sort(int column, Qt::SortOrder order)
 
     QString col_title = get_column_title(column);
 
-    // XXX Use updateProgress instead. We'd have to switch from std::sort to
-    // something we can interrupt.
+    // XXX Use updateProgress instead. sortTextColumn reports its progress in
+    // the status message, but the sort itself can't be interrupted.
     if (!col_title.isEmpty()) {
         QString busy_msg = tr("Sorting \"%1\"…").arg(col_title);
         wsApp->pushStatus(WiresharkApplication::BusyStatus, busy_msg);
@@ -363,7 +388,11 @@ void PacketListModel::sort(int column, Qt::SortOrder order)
 
     busy_timer_.start();
     sort_column_is_numeric_ = isNumericColumn(sort_column_);
-    std::sort(physical_rows_.begin(), physical_rows_.end(), recordLessThan);
+    if (text_sort_column_ >= 0) {
+        sortTextColumn(col_title);
+    } else {
+        std::sort(physical_rows_.begin(), physical_rows_.end(), recordLessThan);
+    }
 
     emit beginResetModel();
     visible_rows_.resize(0);
@@ -514,6 +543,99 @@ bool PacketListModel::recordLessThan(PacketListRecord *r1, PacketListRecord *r2)
     }
 }
 
+// Sorts physical_rows_ by the text of a dissected column. Each record's
+// column text is fetched exactly once up front, since dissection has to
+// happen on this thread. The keys are then sorted in runs on a thread pool
+// and merged, without touching epan.
+void PacketListModel::sortTextColumn(const QString &col_title)
+{
+    int row_count = physical_rows_.count();
+    std::vector<SortKey> keys(row_count);
+
+    for (int i = 0; i < row_count; i++) {
+        PacketListRecord *record = physical_rows_[i];
+        SortKey &key = keys[i];
+
+        key.record = record;
+        key.num = record->frameData()->num;
+        key.text = record->columnString(sort_cap_file_, sort_column_);
+        key.value = 0;
+        key.value_ok = false;
+        if (sort_column_is_numeric_) {
+            key.value = parseNumericColumn(key.text, &key.value_ok);
+        }
+
+        if (busy_timer_.elapsed() > busy_timeout_) {
+            if (!col_title.isEmpty()) {
+                QString busy_msg = tr("Sorting \"%1\"… %2%").arg(col_title).arg(i * 100 / row_count);
+                wsApp->popStatus(WiresharkApplication::BusyStatus);
+                wsApp->pushStatus(WiresharkApplication::BusyStatus, busy_msg);
+            }
+            wsApp->processEvents(QEventLoop::ExcludeUserInputEvents | QEventLoop::ExcludeSocketNotifiers, 1);
+            busy_timer_.restart();
+        }
+    }
+
+    int thread_count = row_count < parallel_sort_min_rows_ ? 1 : QThread::idealThreadCount();
+    if (thread_count < 2) {
+        std::sort(keys.begin(), keys.end(), sortKeyLessThan);
+    } else {
+        // Sort one run per thread, then merge neighboring runs pairwise.
+        QThreadPool pool;
+        pool.setMaxThreadCount(thread_count);
+        size_t run_len = (keys.size() + thread_count - 1) / thread_count;
+        for (size_t first = 0; first < keys.size(); first += run_len) {
+            std::vector<SortKey>::iterator begin = keys.begin() + first;
+            std::vector<SortKey>::iterator end = keys.begin() + std::min(first + run_len, keys.size());
+            pool.start(new SortKeyRunnable([=]() { std::sort(begin, end, sortKeyLessThan); }));
+        }
+        pool.waitForDone();
+        for (; run_len < keys.size(); run_len *= 2) {
+            for (size_t first = 0; first + run_len < keys.size(); first += 2 * run_len) {
+                std::vector<SortKey>::iterator begin = keys.begin() + first;
+                std::vector<SortKey>::iterator middle = begin + run_len;
+                std::vector<SortKey>::iterator end = keys.begin() + std::min(first + 2 * run_len, keys.size());
+                pool.start(new SortKeyRunnable([=]() { std::inplace_merge(begin, middle, end, sortKeyLessThan); }));
+            }
+            pool.waitForDone();
+        }
+    }
+
+    // Records appended while we were processing events stay at the end.
+    for (int i = 0; i < row_count; i++) {
+        physical_rows_[i] = keys[i].record;
+    }
+}
+
+// Same ordering as recordLessThan for text columns.
+bool PacketListModel::sortKeyLessThan(const SortKey &k1, const SortKey &k2)
+{
+    int cmp_val = 0;
+
+    if (sort_column_is_numeric_) {
+        if (!k1.value_ok && !k2.value_ok) {
+            cmp_val = 0;
+        } else if (!k1.value_ok || (k2.value_ok && k1.value < k2.value)) {
+            cmp_val = -1;
+        } else if (!k2.value_ok || (k1.value > k2.value)) {
+            cmp_val = 1;
+        }
+    } else {
+        cmp_val = k1.text.compare(k2.text);
+    }
+
+    if (cmp_val == 0) {
+        // All else being equal, compare column numbers.
+        cmp_val = k1.num < k2.num ? -1 : (k1.num > k2.num ? 1 : 0);
+    }
+
+    if (sort_order_ == Qt::AscendingOrder) {
+        return cmp_val < 0;
+    } else {
+        return cmp_val > 0;
+    }
+}
+
 // Parses a field as a double. Handle values with suffixes ("12ms"), negative
 // values ("-1.23") and fields with multiple occurrences ("1,2"). Marks values
 // that do not contain any numeric value ("Unknown") as invalid.
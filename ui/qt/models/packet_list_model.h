@@ -101,6 +101,18 @@ private:
     static bool recordLessThan(PacketListRecord *r1, PacketListRecord *r2);
     static double parseNumericColumn(const QString &val, bool *ok);
 
+    // Column text (and its numeric value, if any) fetched once per record so
+    // that comparisons don't have to dissect and can run on other threads.
+    struct SortKey {
+        PacketListRecord *record;
+        guint32 num;
+        QString text;
+        double value;
+        bool value_ok;
+    };
+    static bool sortKeyLessThan(const SortKey &k1, const SortKey &k2);
+    void sortTextColumn(const QString &col_title);
+
     QElapsedTimer *idle_dissection_timer_;
     int idle_dissection_row_;
 
@@ -24,12 +24,31 @@
 #include <ui/qt/utils/qt_ui_utils.h>
 
 #include <QStringList>
+#include <QVarLengthArray>
 
 QMap<int, int> PacketListRecord::cinfo_column_;
 unsigned PacketListRecord::col_data_ver_ = 1;
 unsigned PacketListRecord::rows_color_ver_ = 1;
+struct _GStringChunk *PacketListRecord::string_pool_ = NULL;
+GHashTable *PacketListRecord::string_pool_table_ = NULL;
+size_t PacketListRecord::string_pool_bytes_ = 0;
+QQueue<PacketListRecord *> PacketListRecord::text_queue_;
+size_t PacketListRecord::text_cache_bytes_ = 0;
+
+// Column text longer than this is never interned.
+static const size_t max_interned_len_ = 64;
+// Limits on interned text and on per-record column text. Once the latter is
+// reached, the text of records that haven't been used recently is dropped
+// and redissected on demand.
+static const size_t max_string_pool_bytes_ = 32 * 1024 * 1024;
+static const size_t max_text_cache_bytes_ = 256 * 1024 * 1024;
 
 PacketListRecord::PacketListRecord(frame_data *frameData) :
+    col_text_(NULL),
+    col_text_size_(0),
+    col_count_(0),
+    text_referenced_(false),
+    text_queued_(false),
     fdata_(frameData),
     lines_(1),
     line_count_changed_(false),
@@ -43,7 +62,7 @@ PacketListRecord::PacketListRecord(frame_data *frameData) :
 
 PacketListRecord::~PacketListRecord()
 {
-    col_text_.clear();
+    freeColumnStrings();
 }
 
 void PacketListRecord::ensureColorized(capture_file *cap_file)
@@ -83,11 +102,16 @@ const QString PacketListRecord::columnString(capture_file *cap_file, int column,
     // properly colorized?
     //
     bool dissect_color = ( colorized && !colorized_ ) || ( color_ver_ != rows_color_ver_ );
-    if (column >= col_text_.count() || col_text_.at(column).isNull() || data_ver_ != col_data_ver_ || dissect_color) {
+    if (!col_text_ || column >= col_count_ || data_ver_ != col_data_ver_ || dissect_color) {
         dissect(cap_file, dissect_color);
     }
 
-    return col_text_.at(column);
+    if (!col_text_ || column >= col_count_) {
+        return QString();
+    }
+
+    text_referenced_ = true;
+    return QString::fromUtf8(col_text_[column]);
 }
 
 void PacketListRecord::resetColumns(column_info *cinfo)
@@ -117,7 +141,7 @@ void PacketListRecord::dissect(capture_file *cap_file, bool dissect_color)
     wtap_rec rec; /* Record metadata */
     Buffer buf;   /* Record data */
 
-    gboolean dissect_columns = col_text_.isEmpty() || data_ver_ != col_data_ver_;
+    gboolean dissect_columns = !col_text_ || data_ver_ != col_data_ver_;
 
     if (!cap_file) {
         return;
@@ -216,7 +240,6 @@ void PacketListRecord::dissect(capture_file *cap_file, bool dissect_color)
     wtap_rec_cleanup(&rec);
 }
 
-//#define MINIMIZE_STRING_COPYING 1
 void PacketListRecord::cacheColumnStrings(column_info *cinfo)
 {
     // packet_list_store.c:packet_list_change_record(PacketList *packet_list, PacketListRecord *record, gint col, column_info *cinfo)
@@ -224,89 +247,178 @@ void PacketListRecord::cacheColumnStrings(column_info *cinfo)
         return;
     }
 
-    col_text_.clear();
+    freeColumnStrings();
     lines_ = 1;
     line_count_changed_ = false;
 
-    for (int column = 0; column < cinfo->num_cols; ++column) {
-        int col_lines = 1;
+    QVarLengthArray<const char *, 64> col_strs(cinfo->num_cols);
+    QVarLengthArray<const char *, 64> interned(cinfo->num_cols);
+    size_t text_size = 0;
 
-#ifdef MINIMIZE_STRING_COPYING
-        int text_col = cinfo_column_.value(column, -1);
-
-        /* Column based on frame_data or it already contains a value */
-        if (text_col < 0) {
-            col_fill_in_frame_data(fdata_, cinfo, column, FALSE);
-            col_text_ << QString(cinfo->columns[column].col_data);
-            continue;
-        }
+    for (int column = 0; column < cinfo->num_cols; ++column) {
+        const char *col_str;
+        int col_lines = 0;
 
-        switch (cinfo->col_fmt[column]) {
-        case COL_PROTOCOL:
-        case COL_INFO:
-        case COL_IF_DIR:
-        case COL_DCE_CALL:
-        case COL_8021Q_VLAN_ID:
-        case COL_EXPERT:
-        case COL_FREQ_CHAN:
-            if (cinfo->columns[column].col_data && cinfo->columns[column].col_data != cinfo->columns[column].col_buf) {
-                /* This is a constant string, so we don't have to copy it */
-                // XXX - ui/gtk/packet_list_store.c uses G_MAXUSHORT. We don't do proper UTF8
-                // truncation in either case.
-                int col_text_len = MIN(qstrlen(cinfo->col_data[column]) + 1, COL_MAX_INFO_LEN);
-                col_text_ << QString(QByteArray::fromRawData(cinfo->columns[column].col_data, col_text_len));
-                break;
-            }
-            /* !! FALL-THROUGH!! */
-
-        case COL_DEF_SRC:
-        case COL_RES_SRC:        /* COL_DEF_SRC is currently just like COL_RES_SRC */
-        case COL_UNRES_SRC:
-        case COL_DEF_DL_SRC:
-        case COL_RES_DL_SRC:
-        case COL_UNRES_DL_SRC:
-        case COL_DEF_NET_SRC:
-        case COL_RES_NET_SRC:
-        case COL_UNRES_NET_SRC:
-        case COL_DEF_DST:
-        case COL_RES_DST:        /* COL_DEF_DST is currently just like COL_RES_DST */
-        case COL_UNRES_DST:
-        case COL_DEF_DL_DST:
-        case COL_RES_DL_DST:
-        case COL_UNRES_DL_DST:
-        case COL_DEF_NET_DST:
-        case COL_RES_NET_DST:
-        case COL_UNRES_NET_DST:
-        default:
-            if (!get_column_resolved(column) && cinfo->col_expr.col_expr_val[column]) {
-                /* Use the unresolved value in col_expr_val */
-                // XXX Use QContiguousCache?
-                col_text_ << QString(cinfo->col_expr.col_expr_val[column]);
-            } else {
-                col_text_ << QString(cinfo->columns[column].col_data);
-            }
-            break;
-        }
-#else // MINIMIZE_STRING_COPYING
-        QString col_str;
         if (!get_column_resolved(column) && cinfo->col_expr.col_expr_val[column]) {
             /* Use the unresolved value in col_expr_val */
-            col_str = QString(cinfo->col_expr.col_expr_val[column]);
+            col_str = cinfo->col_expr.col_expr_val[column];
         } else {
             int text_col = cinfo_column_.value(column, -1);
 
             if (text_col < 0) {
                 col_fill_in_frame_data(fdata_, cinfo, column, FALSE);
             }
-            col_str = QString(cinfo->columns[column].col_data);
+            col_str = cinfo->columns[column].col_data;
+        }
+        if (!col_str) {
+            col_str = "";
         }
 
-        col_text_ << col_str;
-        col_lines = col_str.count('\n');
+        col_strs[column] = col_str;
+        interned[column] = internColumnString(cinfo->columns[column].col_fmt, col_str);
+        if (!interned[column]) {
+            text_size += strlen(col_str) + 1;
+        }
+
+        for (const char *nl = strchr(col_str, '\n'); nl; nl = strchr(nl + 1, '\n')) {
+            col_lines++;
+        }
         if (col_lines > lines_) {
             lines_ = col_lines;
             line_count_changed_ = true;
         }
-#endif // MINIMIZE_STRING_COPYING
     }
+
+    // One allocation per record: the string pointers, then the text that
+    // wasn't interned.
+    col_text_size_ = (unsigned) (cinfo->num_cols * sizeof(const char *) + text_size);
+    col_text_ = (const char **) g_malloc(col_text_size_);
+    col_count_ = cinfo->num_cols;
+
+    char *text = (char *) (col_text_ + col_count_);
+    for (int column = 0; column < col_count_; ++column) {
+        if (interned[column]) {
+            col_text_[column] = interned[column];
+        } else {
+            size_t len = strlen(col_strs[column]) + 1;
+            memcpy(text, col_strs[column], len);
+            col_text_[column] = text;
+            text += len;
+        }
+    }
+
+    text_cache_bytes_ += col_text_size_;
+    text_referenced_ = true;
+    if (!text_queued_) {
+        text_queue_.enqueue(this);
+        text_queued_ = true;
+    }
+    trimTextCache(this);
+}
+
+void PacketListRecord::freeColumnStrings()
+{
+    if (!col_text_) {
+        return;
+    }
+
+    text_cache_bytes_ -= col_text_size_;
+    g_free(col_text_);
+    col_text_ = NULL;
+    col_text_size_ = 0;
+    col_count_ = 0;
+}
+
+// Returns a shared copy of str if it's from a column whose values repeat a
+// lot, or NULL if the caller should store its own copy.
+const char *PacketListRecord::internColumnString(int col_fmt, const char *str)
+{
+    switch (col_fmt) {
+    case COL_PROTOCOL:
+    case COL_IF_DIR:
+    case COL_DCE_CALL:
+    case COL_8021Q_VLAN_ID:
+    case COL_EXPERT:
+    case COL_FREQ_CHAN:
+    case COL_DEF_SRC:
+    case COL_RES_SRC:
+    case COL_UNRES_SRC:
+    case COL_DEF_DL_SRC:
+    case COL_RES_DL_SRC:
+    case COL_UNRES_DL_SRC:
+    case COL_DEF_NET_SRC:
+    case COL_RES_NET_SRC:
+    case COL_UNRES_NET_SRC:
+    case COL_DEF_DST:
+    case COL_RES_DST:
+    case COL_UNRES_DST:
+    case COL_DEF_DL_DST:
+    case COL_RES_DL_DST:
+    case COL_UNRES_DL_DST:
+    case COL_DEF_NET_DST:
+    case COL_RES_NET_DST:
+    case COL_UNRES_NET_DST:
+    case COL_DEF_SRC_PORT:
+    case COL_RES_SRC_PORT:
+    case COL_UNRES_SRC_PORT:
+    case COL_DEF_DST_PORT:
+    case COL_RES_DST_PORT:
+    case COL_UNRES_DST_PORT:
+        break;
+    default:
+        return NULL;
+    }
+
+    size_t len = strlen(str);
+    if (len > max_interned_len_) {
+        return NULL;
+    }
+
+    if (!string_pool_) {
+        string_pool_ = g_string_chunk_new(4096);
+        string_pool_table_ = g_hash_table_new(g_str_hash, g_str_equal);
+    }
+
+    const char *interned = (const char *) g_hash_table_lookup(string_pool_table_, str);
+    if (!interned) {
+        if (string_pool_bytes_ >= max_string_pool_bytes_) {
+            return NULL;
+        }
+        interned = g_string_chunk_insert(string_pool_, str);
+        g_hash_table_insert(string_pool_table_, (gpointer) interned, (gpointer) interned);
+        string_pool_bytes_ += len + 1;
+    }
+    return interned;
+}
+
+// Drop the column text of records that haven't been displayed or sorted
+// since we last looked at them ("second chance" LRU), oldest first, until
+// we're back under max_text_cache_bytes_.
+void PacketListRecord::trimTextCache(PacketListRecord *keep)
+{
+    while (text_cache_bytes_ > max_text_cache_bytes_ && text_queue_.size() > 1) {
+        PacketListRecord *record = text_queue_.dequeue();
+
+        if (record == keep || (record->col_text_ && record->text_referenced_)) {
+            record->text_referenced_ = false;
+            text_queue_.enqueue(record);
+            continue;
+        }
+        record->text_queued_ = false;
+        record->freeColumnStrings();
+    }
+}
+
+void PacketListRecord::clearTextCache()
+{
+    text_queue_.clear();
+    text_cache_bytes_ = 0;
+
+    if (string_pool_) {
+        g_hash_table_destroy(string_pool_table_);
+        g_string_chunk_free(string_pool_);
+        string_pool_table_ = NULL;
+        string_pool_ = NULL;
+    }
+    string_pool_bytes_ = 0;
 }
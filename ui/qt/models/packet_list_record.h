@@ -21,6 +21,7 @@
 
 #include <QByteArray>
 #include <QList>
+#include <QQueue>
 #include <QVariant>
 
 struct conversation;
@@ -46,13 +47,31 @@ public:
     static void invalidateAllRecords() { col_data_ver_++; }
     static void resetColumns(column_info *cinfo);
     static void resetColorization() { rows_color_ver_++; }
+    // Drop the column text cache. Call after all records have been deleted.
+    static void clearTextCache();
 
     inline int lineCount() { return lines_; }
     inline int lineCountChanged() { return line_count_changed_; }
 
 private:
-    /** The column text for some columns */
-    QStringList col_text_;
+    /** The column text for some columns. A single allocation holding
+     *  col_count_ UTF-8 string pointers, followed by the text of the columns
+     *  that weren't interned. NULL if the text hasn't been cached yet or was
+     *  evicted. */
+    const char **col_text_;
+    unsigned col_text_size_;
+    int col_count_;
+    /** Has our text been used since the cache last checked? */
+    bool text_referenced_;
+    bool text_queued_;
+
+    /** Column text shared between records (protocols, addresses, ports) */
+    static struct _GStringChunk *string_pool_;
+    static GHashTable *string_pool_table_;
+    static size_t string_pool_bytes_;
+    /** Records with cached column text, oldest first */
+    static QQueue<PacketListRecord *> text_queue_;
+    static size_t text_cache_bytes_;
 
     frame_data *fdata_;
     int lines_;
@@ -74,6 +93,9 @@ private:
 
     void dissect(capture_file *cap_file, bool dissect_color = false);
     void cacheColumnStrings(column_info *cinfo);
+    void freeColumnStrings();
+    static const char *internColumnString(int col_fmt, const char *str);
+    static void trimTextCache(PacketListRecord *keep);
 };
 
 #endif // PACKET_LIST_RECORD_H
@@ -16,8 +16,8 @@
 
 // To do:
 // - Draw text by hand similar to ByteViewText. This would let us add
-//   extra information, e.g. a timestamp column and get rid of
-//   max_document_length_ in FollowStreamDialog.
+//   extra information, e.g. a timestamp column, and scroll through the
+//   whole stream instead of FollowStreamDialog's window of it.
 
 FollowStreamText::FollowStreamText(QWidget *parent) :
     QPlainTextEdit(parent)
@@ -88,6 +88,21 @@ gboolean rtpstream_id_equal(const rtpstream_id_t *id1, const rtpstream_id_t *id2
 	return FALSE;
 }
 
+/****************************************************************************/
+/* hash id for use with rtpstream_id_equal(..., RTPSTREAM_ID_EQUAL_SSRC) */
+guint rtpstream_id_to_hash(const rtpstream_id_t *id)
+{
+	guint hash = 0;
+
+	/* ssrc is the most distinctive item, ports and addresses follow */
+	hash ^= id->ssrc;
+	hash ^= id->src_port | id->dst_port << 16;
+	hash = add_address_to_hash(hash, &id->src_addr);
+	hash = add_address_to_hash(hash, &id->dst_addr);
+
+	return hash;
+}
+
 /****************************************************************************/
 /* compare two ids, one in pinfo */
 gboolean rtpstream_id_equal_pinfo_rtp_info(const rtpstream_id_t *id, const packet_info *pinfo, const struct _rtp_info *rtp_info)
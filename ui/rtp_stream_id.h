@@ -63,6 +63,12 @@ void rtpstream_id_free(rtpstream_id_t *id);
 #define RTPSTREAM_ID_EQUAL_SSRC		0x0001
 gboolean rtpstream_id_equal(const rtpstream_id_t *id1, const rtpstream_id_t *id2, guint flags);
 
+/**
+ * Hash rtpstream_id_t
+ * - ids equal with RTPSTREAM_ID_EQUAL_SSRC have equal hashes
+ */
+guint rtpstream_id_to_hash(const rtpstream_id_t *id);
+
 /**
  * Check if rtpstream_id_t is equal to pinfo
  * - compare src_addr, dest_addr, src_port, dest_port with pinfo
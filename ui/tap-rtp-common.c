@@ -122,6 +122,18 @@ gint rtpstream_info_cmp(gconstpointer aa, gconstpointer bb)
         return 1;
 }
 
+/****************************************************************************/
+/* GHashFunc and GEqualFunc for the rtpstream_id_t keys of strinfo_hash */
+static guint rtpstream_info_id_hash(gconstpointer key)
+{
+    return rtpstream_id_to_hash((const rtpstream_id_t *)key);
+}
+
+static gboolean rtpstream_info_id_equal(gconstpointer a, gconstpointer b)
+{
+    return rtpstream_id_equal((const rtpstream_id_t *)a, (const rtpstream_id_t *)b, RTPSTREAM_ID_EQUAL_SSRC);
+}
+
 /****************************************************************************/
 /* compare the endpoints of two RTP streams */
 gboolean rtpstream_info_is_reverse(const rtpstream_info_t *stream_a, rtpstream_info_t *stream_b)
@@ -146,6 +158,12 @@ void rtpstream_reset(rtpstream_tapinfo_t *tapinfo)
     rtpstream_info_t *stream_info;
 
     if (tapinfo->mode == TAP_ANALYSE) {
+        /* the index refers to the ids of the items, drop it first */
+        if (tapinfo->strinfo_hash) {
+            g_hash_table_destroy(tapinfo->strinfo_hash);
+            tapinfo->strinfo_hash = NULL;
+        }
+
         /* free the data items first */
         list = g_list_first(tapinfo->strinfo_list);
         while (list)
@@ -374,7 +392,10 @@ tap_packet_status rtpstream_packet_cb(void *arg, packet_info *pinfo, epan_dissec
     /* gather infos on the stream this packet is part of.
      * Addresses and strings are read-only and must be duplicated if copied. */
     rtpstream_info_init(&new_stream_info);
-    rtpstream_id_copy_pinfo(pinfo,&(new_stream_info.id),FALSE);
+    copy_address_shallow(&(new_stream_info.id.src_addr), &(pinfo->src));
+    new_stream_info.id.src_port = pinfo->srcport;
+    copy_address_shallow(&(new_stream_info.id.dst_addr), &(pinfo->dst));
+    new_stream_info.id.dst_port = pinfo->destport;
     new_stream_info.id.ssrc = rtpinfo->info_sync_src;
     new_stream_info.first_payload_type = rtpinfo->info_payload_type;
     new_stream_info.first_payload_type_name = rtpinfo->info_payload_type_str;
@@ -386,16 +407,15 @@ tap_packet_status rtpstream_packet_cb(void *arg, packet_info *pinfo, epan_dissec
         }
 
         /* check whether we already have a stream with these parameters in the list */
-        list = g_list_first(tapinfo->strinfo_list);
-        while (list)
-        {
-            if (rtpstream_info_cmp(&new_stream_info, (rtpstream_info_t *)(list->data))==0)
-            {
-                stream_info = (rtpstream_info_t *)(list->data);  /*found!*/
-                break;
+        if (!tapinfo->strinfo_hash) {
+            tapinfo->strinfo_hash = g_hash_table_new(rtpstream_info_id_hash, rtpstream_info_id_equal);
+            /* index streams added before the index existed */
+            for (list = g_list_first(tapinfo->strinfo_list); list; list = g_list_next(list)) {
+                stream_info = (rtpstream_info_t *)(list->data);
+                g_hash_table_insert(tapinfo->strinfo_hash, &stream_info->id, stream_info);
             }
-            list = g_list_next(list);
         }
+        stream_info = (rtpstream_info_t *)g_hash_table_lookup(tapinfo->strinfo_hash, &new_stream_info.id);
 
         /* not in the list? then create a new entry */
         if (!stream_info) {
@@ -419,6 +439,7 @@ tap_packet_status rtpstream_packet_cb(void *arg, packet_info *pinfo, epan_dissec
             stream_info = rtpstream_info_malloc_and_init();
             rtpstream_info_copy_deep(stream_info, &new_stream_info);
             tapinfo->strinfo_list = g_list_prepend(tapinfo->strinfo_list, stream_info);
+            g_hash_table_insert(tapinfo->strinfo_hash, &stream_info->id, stream_info);
         }
 
         /* get RTP stats for the packet */